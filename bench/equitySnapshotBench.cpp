@@ -0,0 +1,80 @@
+// Hammers EquityDataBuffer with writers while readers take snapshots and checks that no
+// reader ever observes a torn quote (fields from two different updates) or a sequence
+// going backwards.
+//
+// usage: bench_equity_snapshot [readers] [seconds]
+
+#include "buffer/equityDataBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace stockbot;
+using Field = schwabcpp::StreamerField::LevelOneEquity;
+
+int main(int argc, char* argv[])
+{
+    const int readerCount = argc > 1 ? std::stoi(argv[1]) : 4;
+    const int seconds = argc > 2 ? std::stoi(argv[2]) : 3;
+    const int writerCount = 2;  // two stream workers
+
+    EquityDataBuffer buffer("TEST");
+    std::atomic<bool> running = true;
+    std::atomic<uint64_t> writes = 0;
+    std::atomic<uint64_t> reads = 0;
+    std::atomic<uint64_t> torn = 0;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writerCount; ++w) {
+        threads.emplace_back([&, w] {
+            uint64_t local = 0;
+            // every update sets all four fields from the same base so they are always related
+            for (double base = w * 1e12; running.load(std::memory_order_relaxed); base += 1.0) {
+                LevelOneFieldSet fields;
+                fields.set(Field::LowPrice, base);
+                fields.set(Field::HighPrice, base + 2.0);
+                fields.set(Field::LastPrice, base + 1.0);
+                fields.set(Field::NetPercentChange, -base);
+                buffer.addLevelOneData(fields);
+                ++local;
+            }
+            writes += local;
+        });
+    }
+
+    for (int r = 0; r < readerCount; ++r) {
+        threads.emplace_back([&] {
+            uint64_t local = 0;
+            uint64_t localTorn = 0;
+            uint64_t lastSeq = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                EquityQuote quote = buffer.snapshot();
+                ++local;
+                if (quote.seq == 0) continue;
+
+                bool consistent = quote.hod == quote.lod + 2.0 &&
+                                  quote.lastPrice == quote.lod + 1.0 &&
+                                  quote.netPercentChange == -quote.lod &&
+                                  quote.seq >= lastSeq;
+                if (!consistent) ++localTorn;
+                lastSeq = quote.seq;
+            }
+            reads += local;
+            torn += localTorn;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    running = false;
+    for (auto& thread : threads) thread.join();
+
+    std::printf("writers %d readers %d over %ds\n", writerCount, readerCount, seconds);
+    std::printf("writes  %12.0f /s\n", double(writes) / seconds);
+    std::printf("reads   %12.0f /s\n", double(reads) / seconds);
+    std::printf("torn    %12llu\n", (unsigned long long)torn.load());
+
+    return torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Checks the incremental indicators against naive recomputation over the whole window after
+// every update, then measures the cost of one IndicatorSet update.
+//
+// usage: bench_indicators [updates] [window]
+
+#include "indicator/indicatorSet.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace stockbot;
+
+namespace {
+
+// largest relative error seen for one indicator
+struct ErrorTracker {
+    const char* name;
+    double maxError = 0.0;
+
+    void check(double actual, double expected)
+    {
+        double error = std::abs(actual - expected) / std::max(1.0, std::abs(expected));
+        if (std::isnan(actual) != std::isnan(expected)) {
+            error = INFINITY;
+        }
+        maxError = std::max(maxError, std::isnan(error) ? 0.0 : error);
+    }
+};
+
+std::vector<double> randomWalk(size_t count, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> step(0.0, 0.05);
+    std::vector<double> prices(count);
+    double price = 100.0;
+    for (double& p : prices) {
+        // flat stretches exercise equal values in the deques
+        if (rng() % 8 != 0) {
+            price = std::max(0.01, std::round((price + step(rng)) * 100.0) / 100.0);
+        }
+        p = price;
+    }
+    return prices;
+}
+
+bool verify(const std::vector<double>& prices, size_t window)
+{
+    RollingStats stats(window);
+    RollingMinMax extrema(window);
+    Ema ema(window);
+    Vwap vwap;
+
+    ErrorTracker smaError{ "sma" };
+    ErrorTracker stdDevError{ "stddev" };
+    ErrorTracker minError{ "min" };
+    ErrorTracker maxError{ "max" };
+    ErrorTracker emaError{ "ema" };
+    ErrorTracker vwapError{ "vwap" };
+
+    std::deque<double> recent;
+    double naiveEma = NAN;
+    double alpha = 2.0 / (window + 1.0);
+    double notional = 0.0;
+    double volume = 0.0;
+
+    for (size_t i = 0; i < prices.size(); ++i) {
+        double price = prices[i];
+        double size = double(i % 7 + 1) * 100.0;
+
+        stats.update(price);
+        extrema.update(price);
+        ema.update(price);
+        vwap.update(price, size);
+
+        recent.push_back(price);
+        if (recent.size() > window) {
+            recent.pop_front();
+        }
+        double mean = std::accumulate(recent.begin(), recent.end(), 0.0) / recent.size();
+        double squares = 0.0;
+        for (double p : recent) {
+            squares += (p - mean) * (p - mean);
+        }
+        naiveEma = std::isnan(naiveEma) ? price : alpha * price + (1.0 - alpha) * naiveEma;
+        notional += price * size;
+        volume += size;
+
+        smaError.check(stats.mean(), mean);
+        stdDevError.check(stats.stdDev(), std::sqrt(squares / recent.size()));
+        minError.check(extrema.min(), *std::min_element(recent.begin(), recent.end()));
+        maxError.check(extrema.max(), *std::max_element(recent.begin(), recent.end()));
+        emaError.check(ema.value(), naiveEma);
+        vwapError.check(vwap.value(), notional / volume);
+    }
+
+    bool ok = true;
+    std::printf("%-10s %14s\n", "indicator", "max rel error");
+    for (const ErrorTracker* tracker : { &smaError, &stdDevError, &minError, &maxError, &emaError, &vwapError }) {
+        // Min / max must be exact, the running sums are allowed some rounding drift. The square
+        // root turns the rounding of a near zero variance (flat window) into ~1e-9 absolute.
+        double tolerance = tracker == &minError || tracker == &maxError ? 0.0 : tracker == &stdDevError ? 1e-7 : 1e-9;
+        bool pass = tracker->maxError <= tolerance;
+        ok = ok && pass;
+        std::printf("%-10s %14.3g%s\n", tracker->name, tracker->maxError, pass ? "" : "  FAILED");
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t updates = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t window = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300;
+
+    std::vector<double> prices = randomWalk(updates, 1);
+    std::printf("%zu updates, window %zu\n\n", updates, window);
+    bool ok = verify(prices, window);
+
+    // the set the equity buffers keep, default windows
+    std::vector<double> longWalk = randomWalk(std::max<size_t>(updates, 10'000'000), 2);
+    IndicatorSet indicators(IndicatorSet::Spec{});
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < longWalk.size(); ++i) {
+        indicators.update(int64_t(i), longWalk[i], 100.0);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("\nIndicatorSet::update %.1f ns (last sma %.2f)\n", elapsed.count() / longWalk.size(), indicators.values().sma);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+// Sustained ingest throughput and latency of InvestmentManager under synthetic load.
+//
+// Synthetic LEVELONE_EQUITIES frames go through enqueueStreamData -> decode -> StreamDataBuffer
+// -> createAndRegisterTask for every stream worker count, in partitioned and shared ingest.
+// Latency is from enqueueStreamData to the update being applied (onUpdateApplied). Frames are
+// generated up front so the generator is not part of the measurement.
+//
+// usage: bench_ingest [symbols] [frames] [updates per second, 0 = as fast as possible]
+
+#include "investmentHost.h"
+#include "investmentManager.h"
+#include "rule/tradingWindow.h"
+#include "stream/syntheticFrameGenerator.h"
+#include "taskManager.h"
+#include "utils/timing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace stockbot;
+
+namespace {
+
+class BenchHost : public InvestmentHost
+{
+public:
+    BenchHost(std::shared_ptr<spdlog::logger> logger)
+        : m_taskManager(std::make_unique<TaskManager>(TaskManager::Spec{ .poolSize = 2 }, logger))
+    {
+        m_taskManager->run();
+    }
+
+    void subscribeTickersToStream(const std::vector<std::string>& tickers) override
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_subscribed += tickers.size();
+        }
+        m_cv.notify_all();
+    }
+
+    void registerTask(Task task, const TaskOptions& options) override
+    {
+        m_taskManager->addTask(std::move(task), options);
+    }
+
+    TimerId scheduleTask(int64_t dueNs, Task task, const TaskOptions& options) override
+    {
+        return m_taskManager->addTimer(dueNs, std::move(task), options);
+    }
+
+    void cancelScheduledTask(TimerId id) override { m_taskManager->cancelTimer(id); }
+
+    bool waitForSubscriptions(size_t count)
+    {
+        std::unique_lock lock(m_mutex);
+        return m_cv.wait_for(lock, std::chrono::seconds(10), [&] { return m_subscribed >= count; });
+    }
+
+    void drain() { m_taskManager->stop(); }
+
+private:
+    std::unique_ptr<TaskManager> m_taskManager;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_subscribed = 0;
+};
+
+// one sample buffer per worker thread, no sharing on the ingest path
+class LatencyRecorder
+{
+public:
+    void record(int64_t latencyNs)
+    {
+        thread_local std::vector<int64_t>* samples = nullptr;
+        thread_local LatencyRecorder* owner = nullptr;
+        if (owner != this) {
+            std::lock_guard lock(m_mutex);
+            m_buffers.push_back(std::make_unique<std::vector<int64_t>>());
+            m_buffers.back()->reserve(1 << 20);
+            samples = m_buffers.back().get();
+            owner = this;
+        }
+        samples->push_back(latencyNs);
+    }
+
+    std::vector<int64_t> merged()
+    {
+        std::lock_guard lock(m_mutex);
+        std::vector<int64_t> result;
+        for (const auto& buffer : m_buffers) {
+            result.insert(result.end(), buffer->begin(), buffer->end());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<std::vector<int64_t>>> m_buffers;
+};
+
+double percentileUs(const std::vector<int64_t>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))] / 1000.0;
+}
+
+void run(const std::vector<std::string>& frames,
+         const std::vector<std::string>& tickers,
+         const std::vector<std::chrono::nanoseconds>& due,
+         uint64_t entryCount,
+         int workers,
+         bool partitioned)
+{
+    auto logger = std::make_shared<spdlog::logger>("bench");
+    logger->set_level(spdlog::level::off);
+
+    LatencyRecorder recorder;
+    auto host = std::make_shared<BenchHost>(logger);
+    auto investmentManager = std::make_unique<InvestmentManager>(
+        InvestmentManager::Spec{
+            .streamWorkerCount = workers,
+            .partitionedIngest = partitioned,
+            .persistInvestments = false,
+            .onUpdateApplied = [&](SymbolId, int64_t receivedNs) { recorder.record(monotonicNowNs() - receivedNs); },
+        },
+        host,
+        logger
+    );
+    investmentManager->run();
+
+    // triggered in the current window, the rules run on every tick without signalling
+    const clock::rep triggered = windowOpen(AutoInvestment::Daily, clock::now()).time_since_epoch().count();
+    for (const std::string& ticker : tickers) {
+        investmentManager->addPendingInvestment(AutoInvestment{ .id = ticker, .ticker = ticker, .frequency = AutoInvestment::Daily, .lastTriggerTime = triggered });
+        investmentManager->linkAndRegisterAutoInvestment(ticker, {});
+    }
+    if (!host->waitForSubscriptions(tickers.size())) {
+        std::fprintf(stderr, "registration timed out\n");
+        std::exit(1);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!due.empty()) {
+            std::this_thread::sleep_until(start + due[i]);
+        }
+        investmentManager->enqueueStreamData(frames[i]);
+    }
+    investmentManager->stop();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    host->drain();
+    investmentManager.reset();
+
+    std::vector<int64_t> latency = recorder.merged();
+    std::printf("%-12s %8d %14.0f %14.0f %10.1f %10.1f %10.1f %10.1f%s\n",
+                partitioned ? "partitioned" : "shared", workers,
+                frames.size() / elapsed.count(), entryCount / elapsed.count(),
+                percentileUs(latency, 0.5), percentileUs(latency, 0.99), percentileUs(latency, 0.999),
+                latency.empty() ? 0.0 : latency.back() / 1000.0,
+                latency.size() == entryCount ? "" : "  (update count mismatch!)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t symbolCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    size_t frameCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+    double rate = argc > 3 ? std::atof(argv[3]) : 0.0;
+
+    SyntheticFrameGenerator generator({
+        .symbolCount = symbolCount,
+        .updatesPerSecond = rate > 0.0 ? rate : 1.0,
+    });
+    std::vector<std::string> frames(frameCount);
+    std::vector<std::chrono::nanoseconds> due;
+    for (std::string& frame : frames) {
+        std::chrono::nanoseconds at = generator.next(frame);
+        if (rate > 0.0) {
+            due.push_back(at);
+        }
+    }
+
+    std::printf("%zu symbols, %zu frames, %llu updates, %s\n\n", symbolCount, frameCount,
+                (unsigned long long)generator.entryCount(),
+                rate > 0.0 ? (std::to_string(size_t(rate)) + " updates/s").c_str() : "as fast as possible");
+    std::printf("%-12s %8s %14s %14s %10s %10s %10s %10s\n",
+                "ingest", "workers", "frames/s", "updates/s", "p50 us", "p99 us", "p999 us", "max us");
+
+    for (bool partitioned : { true, false }) {
+        for (int workers : { 1, 2, 4, 8 }) {
+            run(frames, generator.tickers(), due, generator.entryCount(), workers, partitioned);
+        }
+    }
+
+    return 0;
+}
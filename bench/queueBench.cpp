@@ -0,0 +1,106 @@
+// Throughput of ConcurrentQueue against the lock free RingQueue (MPMC and SPSC) with
+// producers and consumers passing integers and frame sized strings.
+//
+// usage: bench_queue [items per producer]
+
+#include "utils/concurrentQueue.h"
+#include "utils/ringQueue.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace stockbot;
+
+namespace {
+
+template <typename T>
+T makeItem(size_t i);
+
+template <>
+uint64_t makeItem<uint64_t>(size_t i) { return i; }
+
+template <>
+std::string makeItem<std::string>(size_t i) { return std::string(300, 'a' + (i % 26)); }
+
+uint64_t itemValue(uint64_t item) { return item; }
+uint64_t itemValue(const std::string& item) { return item[0] - 'a'; }
+
+// returns items per second, verifies every item arrived exactly once by checksum
+template <typename Queue, typename T>
+double run(Queue& queue, int producers, int consumers, size_t itemsPerProducer, bool& ok)
+{
+    std::vector<T> items;
+    for (size_t i = 0; i < 64; ++i) items.push_back(makeItem<T>(i));
+
+    std::atomic<uint64_t> consumed = 0;
+    std::atomic<uint64_t> checksum = 0;
+    const uint64_t total = uint64_t(producers) * itemsPerProducer;
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            T item;
+            uint64_t localSum = 0;
+            while (queue.pop(item)) {
+                localSum += itemValue(item);
+                if (consumed.fetch_add(1, std::memory_order_relaxed) + 1 == total) {
+                    queue.shutdown();
+                }
+            }
+            checksum += localSum;
+        });
+    }
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (size_t i = 0; i < itemsPerProducer; ++i) {
+                queue.push(items[i % items.size()]);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint64_t expected = 0;
+    for (size_t i = 0; i < itemsPerProducer; ++i) expected += itemValue(items[i % items.size()]);
+    ok = ok && consumed == total && checksum == expected * producers;
+
+    return double(total) / elapsed.count();
+}
+
+template <typename T>
+void compare(const char* label, size_t itemsPerProducer, bool& ok)
+{
+    std::printf("\n%s\n%8s %16s %16s %16s\n", label, "P x C", "concurrent/s", "ring mpmc/s", "ring spsc/s");
+    for (auto [producers, consumers] : {std::pair{1, 1}, std::pair{2, 2}, std::pair{4, 4}}) {
+        ConcurrentQueue<T> concurrent;
+        double concurrentRate = run<ConcurrentQueue<T>, T>(concurrent, producers, consumers, itemsPerProducer, ok);
+
+        RingQueue<T> mpmc(4096);
+        double mpmcRate = run<RingQueue<T>, T>(mpmc, producers, consumers, itemsPerProducer, ok);
+
+        double spscRate = 0.0;
+        if (producers == 1 && consumers == 1) {
+            RingQueue<T, QueueMode::SPSC> spsc(4096);
+            spscRate = run<RingQueue<T, QueueMode::SPSC>, T>(spsc, producers, consumers, itemsPerProducer, ok);
+        }
+
+        std::printf("%4d x %-2d %16.0f %16.0f %16.0f\n", producers, consumers, concurrentRate, mpmcRate, spscRate);
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t itemsPerProducer = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    bool ok = true;
+    compare<uint64_t>("uint64_t", itemsPerProducer, ok);
+    compare<std::string>("300 byte std::string", itemsPerProducer / 4, ok);
+
+    std::printf("\n%s\n", ok ? "all items delivered" : "ITEMS LOST OR DUPLICATED");
+    return ok ? 0 : 1;
+}
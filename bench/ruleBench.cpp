@@ -0,0 +1,135 @@
+// RuleSet::evaluate throughput per kernel with many investments on one ticker, and a check that
+// every kernel makes the same decisions as a straightforward per investment evaluation.
+//
+// steady: every window already consumed, the common case on the tick path
+// open:   every rule due (first quote of the day), every rule produces a decision
+//
+// usage: bench_rules [investments] [iterations]
+
+#include "rule/ruleSet.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace stockbot;
+
+namespace {
+
+std::vector<AutoInvestment> makeInvestments(size_t count, clock::rep lastTrigger, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> threshold(0.0, 0.05);
+    std::vector<AutoInvestment> investments(count);
+    for (size_t i = 0; i < count; ++i) {
+        AutoInvestment& investment = investments[i];
+        investment.id = "bench-" + std::to_string(i);
+        investment.ticker = "NVDA";
+        investment.frequency = rng() % 4 == 0 ? AutoInvestment::Weekly : AutoInvestment::Daily;
+        investment.shares = 1 + int(rng() % 10);
+        investment.extras = int(rng() % 5);
+        // some with a threshold disabled
+        investment.averageInThreshold = rng() % 8 == 0 ? 0.0 : threshold(rng);
+        investment.skipThreshold = rng() % 8 == 0 ? 0.0 : threshold(rng);
+        investment.createdTime = 0;
+        investment.lastTriggerTime = lastTrigger;
+    }
+    return investments;
+}
+
+// the rules spelled out one investment at a time
+std::vector<RuleDecision> reference(const std::vector<AutoInvestment>& investments, const RuleInputs& inputs)
+{
+    std::vector<RuleDecision> decisions;
+    for (size_t i = 0; i < investments.size(); ++i) {
+        const AutoInvestment& investment = investments[i];
+        if (investment.lastTriggerTime >= inputs.windowStarts[investment.frequency]) {
+            continue;
+        }
+
+        bool skip = investment.skipThreshold > 0.0 && inputs.change >= investment.skipThreshold;
+        bool dip = investment.averageInThreshold > 0.0 && inputs.change <= -investment.averageInThreshold;
+        if (skip) {
+            decisions.push_back({ uint32_t(i), RuleSignal::Skip, investment.shares });
+        } else if (dip) {
+            if (inputs.rebound >= RuleSet::MIN_REBOUND) {
+                decisions.push_back({ uint32_t(i), RuleSignal::AverageIn, investment.shares + investment.extras });
+            }
+        } else {
+            decisions.push_back({ uint32_t(i), RuleSignal::Buy, investment.shares });
+        }
+    }
+    return decisions;
+}
+
+bool same(const std::vector<RuleDecision>& a, const std::vector<RuleDecision>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].rule != b[i].rule || a[i].signal != b[i].signal || a[i].shares != b[i].shares) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t maxInvestments = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+    clock::time_point now = clock::now();
+    auto windowStarts = RuleSet::windowStarts(now);
+    clock::rep triggeredToday = now.time_since_epoch().count();
+
+    // quotes around the thresholds, both sides of the rebound
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> change(-0.06, 0.06);
+    std::uniform_real_distribution<double> rebound(0.0, 0.005);
+    std::vector<RuleInputs> quotes(256);
+    for (RuleInputs& quote : quotes) {
+        quote = RuleInputs{ change(rng), rebound(rng), windowStarts };
+    }
+
+    bool ok = true;
+    std::printf("%-8s %10s %8s %12s %14s\n", "case", "rules", "kernel", "ns/eval", "rules/us");
+    for (size_t count : { size_t(16), size_t(256), size_t(10000), maxInvestments }) {
+        for (bool open : { false, true }) {
+            std::vector<AutoInvestment> investments = makeInvestments(count, open ? 0 : triggeredToday, count);
+            RuleSet rules(investments);
+
+            for (RuleKernel kernel : { RuleKernel::Scalar, RuleKernel::Sse, RuleKernel::Avx2 }) {
+                if (resolveRuleKernel(kernel) != kernel) {
+                    continue;
+                }
+
+                std::vector<RuleDecision> decisions;
+                for (const RuleInputs& quote : quotes) {
+                    decisions.clear();
+                    rules.evaluate(quote, decisions, kernel);
+                    if (!same(decisions, reference(investments, quote))) {
+                        std::printf("%s kernel differs from the reference with %zu rules\n", toString(kernel), count);
+                        ok = false;
+                        break;
+                    }
+                }
+
+                size_t rounds = std::max<size_t>(1, iterations * 1000 / count);
+                size_t fired = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t r = 0; r < rounds; ++r) {
+                    decisions.clear();
+                    fired += rules.evaluate(quotes[r % quotes.size()], decisions, kernel);
+                }
+                std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+                double perEval = elapsed.count() / rounds;
+                std::printf("%-8s %10zu %8s %12.1f %14.1f%s\n", open ? "open" : "steady", count, toString(kernel),
+                            perEval, count / perEval * 1000.0, fired || !open ? "" : "  (nothing fired?)");
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
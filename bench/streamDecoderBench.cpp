@@ -0,0 +1,187 @@
+// Compares the single pass StreamFrameDecoder with the nlohmann DOM walk that
+// InvestmentManager::processStreamData used before.
+//
+// usage: bench_stream_decoder [frames.txt] [iterations]
+//   frames.txt: recorded streamer frames, one per line
+//               synthetic LEVELONE_EQUITIES frames are used when omitted
+
+#include "stream/streamFrameDecoder.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace stockbot;
+using json = nlohmann::json;
+using LevelOneEquity = schwabcpp::StreamerField::LevelOneEquity;
+
+namespace {
+
+struct Totals {
+    size_t  entries = 0;
+    size_t  fields = 0;
+    double  checksum = 0.0;
+};
+
+// the previous processStreamData, minus the buffer update
+void decodeWithDom(const std::string& data, Totals& totals)
+{
+    json jsonData = json::parse(data);
+    if (!jsonData.contains("data")) return;
+
+    for (const json& serviceData : jsonData["data"]) {
+        if (serviceData["service"] == "LEVELONE_EQUITIES" &&
+            serviceData["command"] == "SUBS"
+        ) {
+            std::string ticker("");
+            for (const json& contentData : serviceData["content"]) {
+                // per entry here so both paths produce the same totals
+                std::unordered_map<LevelOneEquity, double> fields;
+                for (auto it = contentData.begin(); it != contentData.end(); ++it) {
+                    const auto& key = it.key();
+                    const auto& val = it.value();
+                    if (key == "delayed" ||
+                        key == "assetMainType" ||
+                        key == "assetSubType" ||
+                        key == "cusip"
+                    ) {
+                        continue;
+                    } else if (key == "key") {
+                        ticker = val;
+                    } else {
+                        fields.emplace(schwabcpp::StreamerField::toLevelOneEquityField(key), val.get<double>());
+                    }
+                }
+                totals.entries += 1;
+                totals.fields += fields.size();
+                for (const auto& [_, value] : fields) totals.checksum += value;
+            }
+        }
+    }
+}
+
+class CountingHandler : public StreamFrameDecoder::Handler
+{
+public:
+    explicit CountingHandler(Totals& totals) : m_totals(totals) {}
+
+    void onLevelOneEquity(std::string_view, const LevelOneFieldSet& fields) override
+    {
+        m_totals.entries += 1;
+        m_totals.fields += fields.size();
+        fields.forEach([this](LevelOneEquity, double value) { m_totals.checksum += value; });
+    }
+
+private:
+    Totals& m_totals;
+};
+
+std::vector<std::string> synthesizeFrames(size_t frameCount, size_t tickersPerFrame)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> price(10.0, 900.0);
+    std::uniform_real_distribution<double> pct(-8.0, 8.0);
+    std::bernoulli_distribution partial(0.6);
+
+    std::vector<std::string> frames;
+    frames.reserve(frameCount);
+    for (size_t i = 0; i < frameCount; ++i) {
+        json content = json::array();
+        for (size_t t = 0; t < tickersPerFrame; ++t) {
+            json entry = {{"key", "TICK" + std::to_string(t)}};
+            if (i == 0) {
+                entry["delayed"] = false;
+                entry["assetMainType"] = "EQUITY";
+                entry["assetSubType"] = "COE";
+                entry["cusip"] = "037833100";
+            }
+            // partial updates only carry the fields that changed
+            entry["3"] = price(rng);
+            if (!partial(rng)) {
+                entry["10"] = price(rng);
+                entry["11"] = price(rng);
+                entry["42"] = pct(rng);
+            }
+            content.push_back(entry);
+        }
+        json frame = {
+            {"data", json::array({
+                {
+                    {"service", "LEVELONE_EQUITIES"},
+                    {"timestamp", 1715908546054 + i},
+                    {"command", "SUBS"},
+                    {"content", content},
+                }
+            })}
+        };
+        frames.push_back(frame.dump());
+    }
+    return frames;
+}
+
+template <typename Fn>
+double measure(const std::vector<std::string>& frames, size_t iterations, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        for (const std::string& frame : frames) {
+            fn(frame);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / double(frames.size() * iterations);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> frames;
+    if (argc > 1) {
+        std::ifstream file(argv[1]);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) frames.push_back(line);
+        }
+        std::printf("loaded %zu frames from %s\n", frames.size(), argv[1]);
+    } else {
+        frames = synthesizeFrames(2000, 50);
+        std::printf("synthesized %zu frames with 50 tickers each\n", frames.size());
+    }
+    if (frames.empty()) return 1;
+
+    size_t iterations = argc > 2 ? std::stoul(argv[2]) : 20;
+
+    size_t bytes = 0;
+    for (const std::string& frame : frames) bytes += frame.size();
+
+    Totals domTotals;
+    double domNs = measure(frames, iterations, [&](const std::string& frame) {
+        try {
+            decodeWithDom(frame, domTotals);
+        } catch (const json::exception&) {
+        }
+    });
+
+    Totals decoderTotals;
+    CountingHandler handler(decoderTotals);
+    StreamFrameDecoder decoder;
+    double decoderNs = measure(frames, iterations, [&](const std::string& frame) {
+        decoder.decode(frame, handler);
+    });
+
+    auto report = [&](const char* name, double nsPerFrame, const Totals& totals) {
+        double mbPerSec = (double(bytes) / frames.size()) / nsPerFrame * 1e3;
+        std::printf("%-10s %10.1f ns/frame %10.1f MB/s   entries %zu fields %zu checksum %.4f\n",
+                    name, nsPerFrame, mbPerSec, totals.entries, totals.fields, totals.checksum);
+    };
+    report("dom", domNs, domTotals);
+    report("decoder", decoderNs, decoderTotals);
+    std::printf("speedup    %10.2fx\n", domNs / decoderNs);
+
+    return domTotals.entries == decoderTotals.entries && domTotals.fields == decoderTotals.fields ? 0 : 2;
+}
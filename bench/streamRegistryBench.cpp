@@ -0,0 +1,100 @@
+// Ingest scaling of the StreamDataBuffer registry against the previous design
+// (one global mutex around a string keyed map, looked up twice per tick). Both start from the
+// ticker string of the frame, the indexed path resolves it through the SymbolTable like
+// onLevelOneEquity does.
+//
+// usage: bench_stream_registry [symbols] [updates per thread]
+
+#include "buffer/equityDataBuffer.h"
+#include "buffer/streamDataBuffer.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace stockbot;
+using Field = schwabcpp::StreamerField::LevelOneEquity;
+
+namespace {
+
+// the registry before it was indexed by SymbolId
+class LegacyRegistry
+{
+public:
+    std::weak_ptr<EquityDataBuffer> addLevelOneEquityData(const std::string& ticker, const LevelOneFieldSet& fields)
+    {
+        std::shared_ptr<EquityDataBuffer> targetBuffer;
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_equityDataBuffers.contains(ticker)) {
+                m_equityDataBuffers[ticker] = std::make_shared<EquityDataBuffer>(ticker);
+            }
+            targetBuffer = m_equityDataBuffers[ticker];
+        }
+        targetBuffer->addLevelOneData(fields);
+        return targetBuffer;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<EquityDataBuffer>> m_equityDataBuffers;
+};
+
+template <typename Fn>
+double run(int threadCount, size_t updatesPerThread, Fn fn)
+{
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            LevelOneFieldSet fields;
+            for (size_t i = 0; i < updatesPerThread; ++i) {
+                fields.set(Field::LastPrice, double(i));
+                fn(t, i, fields);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return double(threadCount * updatesPerThread) / elapsed.count();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t symbolCount = argc > 1 ? std::stoul(argv[1]) : 500;
+    const size_t updatesPerThread = argc > 2 ? std::stoul(argv[2]) : 500000;
+
+    std::vector<std::string> tickers;
+    std::vector<SymbolId> symbols;
+    for (size_t i = 0; i < symbolCount; ++i) {
+        tickers.push_back("SYM" + std::to_string(i));
+        symbols.push_back(SymbolTable::instance().intern(tickers.back()));
+    }
+
+    std::printf("%zu symbols, %zu updates per thread\n", symbolCount, updatesPerThread);
+    std::printf("%8s %16s %16s %8s\n", "threads", "legacy ticks/s", "indexed ticks/s", "ratio");
+
+    for (int threadCount : {1, 2, 4, 8, 16}) {
+        LegacyRegistry legacy;
+        double legacyRate = run(threadCount, updatesPerThread, [&](int t, size_t i, const LevelOneFieldSet& fields) {
+            // spread the threads over different symbols like the stream workers would be
+            auto ref = legacy.addLevelOneEquityData(tickers[(i * 7 + t * 131) % symbolCount], fields);
+        });
+
+        StreamDataBuffer registry;
+        for (SymbolId symbol : symbols) registry.registerSymbol(symbol);
+        double indexedRate = run(threadCount, updatesPerThread, [&](int t, size_t i, const LevelOneFieldSet& fields) {
+            registry.addLevelOneEquityData(SymbolTable::instance().find(tickers[(i * 7 + t * 131) % symbolCount]), fields);
+        });
+
+        std::printf("%8d %16.0f %16.0f %7.2fx\n", threadCount, legacyRate, indexedRate, indexedRate / legacyRate);
+    }
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+// Throughput of the work stealing TaskManager against the single shared queue pool it replaced.
+//
+// fan-out: the main thread adds root tasks, every root adds children from its worker and every
+// child does a little work on a buffer the root filled, the analysis task shape. external: every
+// task is added from the main thread, the stream ingest shape. lanes: a flood of normal tasks
+// with a critical task and a background task with a short deadline mixed in, per dispatch policy.
+// allocs/task counts every heap allocation of the process while the load runs, the tasks of the
+// old pool were std::function and allocated their captures.
+//
+// usage: bench_tasks [roots] [children per root] [work per child]
+
+#include "taskManager.h"
+#include "utils/latencyMetrics.h"
+#include "utils/ringQueue.h"
+#include "utils/timing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace stockbot;
+
+// Every replaceable allocation form is replaced, the plain and array ones as well as the
+// aligned ones, so nothing the process allocates goes uncounted or is freed by a mismatched
+// function. The nothrow forms call these by default.
+static std::atomic<uint64_t> g_allocations = 0;
+
+static void* allocate(size_t size, size_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    // aligned_alloc wants a multiple of the alignment
+    size = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+    if (void* p = std::aligned_alloc(alignment, size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size) { return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, size_t(alignment)); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+// The previous TaskManager: one MPMC ring every worker pops batches from. Its ring had the
+// capacity of the inject queue; with that, fan-out deadlocks once the workers all block adding
+// children to a full ring, so that load runs it with a ring that holds everything.
+template <size_t Capacity>
+class SharedQueuePool
+{
+    struct QueuedTask {
+        std::function<void()> task;
+        int64_t queuedNs = 0;
+    };
+
+public:
+    SharedQueuePool(const TaskManager::Spec& spec, std::shared_ptr<spdlog::logger>)
+        : m_queue(Capacity)
+        , m_threads(spec.poolSize)
+    {}
+
+    ~SharedQueuePool()
+    {
+        m_queue.shutdown(ShutdownMode::Drain);
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void run()
+    {
+        for (auto& thread : m_threads) {
+            thread = std::thread([this] {
+                LatencyMetrics& metrics = LatencyMetrics::instance();
+                std::vector<QueuedTask> tasks;
+                while (m_queue.popBulk(std::back_inserter(tasks), 16)) {
+                    for (QueuedTask& queued : tasks) {
+                        int64_t startNs = monotonicNowNs();
+                        metrics.record(LatencyStage::NormalTaskWait, startNs - queued.queuedNs);
+                        queued.task();
+                        metrics.record(LatencyStage::TaskRun, monotonicNowNs() - startNs);
+                    }
+                    tasks.clear();
+                }
+            });
+        }
+    }
+
+    void addTask(std::function<void()> task) { m_queue.push(QueuedTask{ std::move(task), monotonicNowNs() }); }
+
+private:
+    RingQueue<QueuedTask> m_queue;
+    std::vector<std::thread> m_threads;
+};
+
+struct Load {
+    size_t roots;
+    size_t children;
+    size_t work;
+};
+
+struct Result {
+    double tasksPerSecond;
+    double allocationsPerTask;
+    uint64_t checksum;
+};
+
+uint64_t childWork(const std::vector<uint64_t>& data, size_t child, size_t work)
+{
+    uint64_t sum = child;
+    for (size_t i = 0; i < work; ++i) {
+        sum = sum * 31 + data[(child + i) % data.size()];
+    }
+    return sum;
+}
+
+void waitFor(const std::atomic<uint64_t>& done, uint64_t total)
+{
+    while (done.load(std::memory_order_acquire) < total) {
+        std::this_thread::yield();
+    }
+}
+
+template <typename Pool>
+Result fanOut(int workers, const Load& load)
+{
+    auto logger = std::make_shared<spdlog::logger>("bench");
+    logger->set_level(spdlog::level::off);
+    Pool pool(TaskManager::Spec{ .poolSize = workers }, logger);
+    pool.run();
+
+    std::atomic<uint64_t> done = 0;
+    std::atomic<uint64_t> sum = 0;
+    const uint64_t total = load.roots * (load.children + 1);
+
+    uint64_t allocations = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < load.roots; ++r) {
+        pool.addTask([&pool, &load, &done, &sum, r] {
+            auto data = std::make_shared<std::vector<uint64_t>>(256);
+            std::iota(data->begin(), data->end(), r);
+            for (size_t c = 0; c < load.children; ++c) {
+                pool.addTask([data, &load, &done, &sum, c] {
+                    sum.fetch_add(childWork(*data, c, load.work), std::memory_order_relaxed);
+                    done.fetch_add(1, std::memory_order_release);
+                });
+            }
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    waitFor(done, total);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return Result{ total / elapsed.count(), double(g_allocations.load() - allocations) / total, sum.load() };
+}
+
+template <typename Pool>
+Result external(int workers, const Load& load)
+{
+    auto logger = std::make_shared<spdlog::logger>("bench");
+    logger->set_level(spdlog::level::off);
+    Pool pool(TaskManager::Spec{ .poolSize = workers }, logger);
+    pool.run();
+
+    std::atomic<uint64_t> done = 0;
+    std::atomic<uint64_t> sum = 0;
+    const uint64_t total = load.roots * load.children;
+    auto data = std::make_shared<std::vector<uint64_t>>(256);
+    std::iota(data->begin(), data->end(), 0);
+
+    uint64_t allocations = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < total; ++i) {
+        pool.addTask([data, &load, &done, &sum, i] {
+            sum.fetch_add(childWork(*data, i % load.children, load.work), std::memory_order_relaxed);
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    waitFor(done, total);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return Result{ total / elapsed.count(), double(g_allocations.load() - allocations) / total, sum.load() };
+}
+
+// wait of every lane, how many background tasks ran and expired
+void lanes(TaskDispatch dispatch, int workers, const Load& load)
+{
+    auto logger = std::make_shared<spdlog::logger>("bench");
+    logger->set_level(spdlog::level::off);
+    LatencyMetrics& metrics = LatencyMetrics::instance();
+    for (size_t stage = 0; stage < size_t(LatencyStage::Count); ++stage) {
+        metrics.summary(LatencyStage(stage));
+    }
+
+    std::atomic<uint64_t> done = 0;
+    std::atomic<uint64_t> backgroundRun = 0;
+    uint64_t total = 0;
+    uint64_t background = 0;
+    auto data = std::make_shared<std::vector<uint64_t>>(256);
+    std::iota(data->begin(), data->end(), 0);
+    {
+        TaskManager pool(TaskManager::Spec{ .poolSize = workers, .dispatch = dispatch }, logger);
+        pool.run();
+
+        auto work = [data, &load, &done](uint64_t i) {
+            return [data, &load, &done, i] {
+                volatile uint64_t sink = childWork(*data, i % load.children, load.work);
+                (void)sink;
+                done.fetch_add(1, std::memory_order_release);
+            };
+        };
+        for (uint64_t i = 0; i < load.roots * load.children; ++i) {
+            pool.addTask(work(i));
+            ++total;
+            if (i % 64 == 0) {
+                pool.addTask(work(i), { .priority = TaskPriority::Critical });
+                pool.addTask([&backgroundRun, &done] {
+                    backgroundRun.fetch_add(1, std::memory_order_relaxed);
+                    done.fetch_add(1, std::memory_order_release);
+                }, { .priority = TaskPriority::Background, .deadlineNs = monotonicNowNs() + 1000000 });
+                total += 1;
+                ++background;
+            }
+        }
+        // the expired ones never count as done
+        while (done.load(std::memory_order_acquire) + pool.expiredCount(TaskPriority::Background) < total + background) {
+            std::this_thread::yield();
+        }
+    }
+
+    LatencySummary critical = metrics.summary(LatencyStage::CriticalTaskWait);
+    LatencySummary normal = metrics.summary(LatencyStage::NormalTaskWait);
+    LatencySummary late = metrics.summary(LatencyStage::BackgroundTaskWait);
+    std::printf("%-10s %8d %14.1f %14.1f %14.1f %14.1f %10llu/%llu\n",
+                dispatch == TaskDispatch::Strict ? "strict" : "weighted", workers,
+                critical.p50 / 1e3, critical.p99 / 1e3, normal.p99 / 1e3, late.p99 / 1e3,
+                (unsigned long long)backgroundRun.load(), (unsigned long long)background);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Load load{
+        .roots = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000,
+        .children = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16,
+        .work = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64,
+    };
+
+    std::vector<int> workerCounts = { 1, 2, 4 };
+    int hardware = int(std::thread::hardware_concurrency());
+    if (hardware > 4) {
+        workerCounts.push_back(hardware);
+    }
+
+    std::printf("%zu roots, %zu children per root, %zu work per child\n\n", load.roots, load.children, load.work);
+    std::printf("%-10s %8s %16s %16s %8s %14s %14s\n", "load", "workers", "shared tasks/s", "stealing tasks/s", "speedup",
+                "shared allocs", "stealing allocs");
+
+    bool ok = true;
+    auto print = [&ok](const char* name, int workers, const Result& shared, const Result& stealing) {
+        ok &= stealing.checksum == shared.checksum;
+        std::printf("%-10s %8d %16.0f %16.0f %7.2fx %14.2f %14.2f%s\n", name, workers, shared.tasksPerSecond, stealing.tasksPerSecond,
+                    stealing.tasksPerSecond / shared.tasksPerSecond, shared.allocationsPerTask, stealing.allocationsPerTask,
+                    stealing.checksum == shared.checksum ? "" : "  (checksum mismatch!)");
+    };
+    for (int workers : workerCounts) {
+        Result shared = fanOut<SharedQueuePool<(1 << 20)>>(workers, load);
+        print("fan-out", workers, shared, fanOut<TaskManager>(workers, load));
+    }
+    for (int workers : workerCounts) {
+        Result shared = external<SharedQueuePool<(1 << 13)>>(workers, load);
+        print("external", workers, shared, external<TaskManager>(workers, load));
+    }
+
+    std::printf("\n%-10s %8s %14s %14s %14s %14s %10s\n", "lanes", "workers", "crit p50 us", "crit p99 us",
+                "normal p99 us", "backgr p99 us", "backgr run");
+    for (TaskDispatch dispatch : { TaskDispatch::Strict, TaskDispatch::Weighted }) {
+        for (int workers : workerCounts) {
+            lanes(dispatch, workers, load);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+// Cost of the TimerWheel operations with thousands of pending timers, and how late the
+// TaskManager queues its timer tasks.
+//
+// wheel: schedules timers spread over the next minutes, cancels half of them and advances
+// through all of them in 1ms steps, against a std::multimap doing the same. lateness: timers a
+// few ms apart on a running pool, the delay between their due time and their task starting.
+//
+// usage: bench_timers [timers] [lateness samples]
+
+#include "taskManager.h"
+#include "utils/latencyMetrics.h"
+#include "utils/timerWheel.h"
+#include "utils/timing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace stockbot;
+
+namespace {
+
+constexpr int64_t MS = 1'000'000;
+
+struct OpCosts {
+    double schedule;    // ns per op
+    double cancel;
+    double advance;     // ns per fired timer
+    size_t fired;
+};
+
+double nsPerOp(std::chrono::steady_clock::time_point start, size_t ops)
+{
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return ops ? elapsed.count() / ops : 0.0;
+}
+
+OpCosts wheel(const std::vector<int64_t>& dues, int64_t endNs)
+{
+    TimerWheel<uint64_t> timers(0);
+    std::vector<TimerWheel<uint64_t>::TimerId> ids(dues.size());
+    std::vector<uint64_t> fired;
+    fired.reserve(dues.size());
+
+    OpCosts costs{};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < dues.size(); ++i) {
+        ids[i] = timers.schedule(dues[i], i);
+    }
+    costs.schedule = nsPerOp(start, dues.size());
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        timers.cancel(ids[i]);
+    }
+    costs.cancel = nsPerOp(start, ids.size() / 2);
+
+    start = std::chrono::steady_clock::now();
+    for (int64_t now = MS; now <= endNs; now += MS) {
+        timers.advance(now, fired);
+    }
+    costs.fired = fired.size();
+    costs.advance = nsPerOp(start, fired.size());
+    return costs;
+}
+
+// the ordered container a timer list would otherwise be
+OpCosts multimap(const std::vector<int64_t>& dues, int64_t endNs)
+{
+    std::multimap<int64_t, uint64_t> timers;
+    std::vector<std::multimap<int64_t, uint64_t>::iterator> ids(dues.size());
+    std::vector<uint64_t> fired;
+    fired.reserve(dues.size());
+
+    OpCosts costs{};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < dues.size(); ++i) {
+        ids[i] = timers.emplace(dues[i], i);
+    }
+    costs.schedule = nsPerOp(start, dues.size());
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        timers.erase(ids[i]);
+    }
+    costs.cancel = nsPerOp(start, ids.size() / 2);
+
+    start = std::chrono::steady_clock::now();
+    for (int64_t now = MS; now <= endNs; now += MS) {
+        auto end = timers.upper_bound(now);
+        for (auto it = timers.begin(); it != end; ++it) {
+            fired.push_back(it->second);
+        }
+        timers.erase(timers.begin(), end);
+    }
+    costs.fired = fired.size();
+    costs.advance = nsPerOp(start, fired.size());
+    return costs;
+}
+
+void lateness(size_t samples)
+{
+    auto logger = std::make_shared<spdlog::logger>("bench");
+    logger->set_level(spdlog::level::off);
+    LatencyMetrics& metrics = LatencyMetrics::instance();
+
+    std::vector<int64_t> late(samples);
+    std::atomic<size_t> done = 0;
+    {
+        TaskManager pool(TaskManager::Spec{ .poolSize = 2 }, logger);
+        pool.run();
+        metrics.summary(LatencyStage::TimerLate);
+
+        // a few ms apart so the timer thread sleeps in between
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<int64_t> gap(MS, 3 * MS);
+        int64_t due = monotonicNowNs() + 10 * MS;
+        for (size_t i = 0; i < samples; ++i) {
+            due += gap(rng);
+            pool.addTimer(due, [&late, &done, i, due] {
+                late[i] = monotonicNowNs() - due;
+                done.fetch_add(1, std::memory_order_release);
+            }, { .priority = TaskPriority::Critical });
+        }
+        while (done.load(std::memory_order_acquire) < samples) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    LatencySummary queued = metrics.summary(LatencyStage::TimerLate);
+    std::sort(late.begin(), late.end());
+    auto at = [&late](double q) { return late[std::min(late.size() - 1, size_t(q * late.size()))] / 1e3; };
+    std::printf("%-14s %10.1f %10.1f %10.1f %10.1f\n", "timer queued", queued.p50 / 1e3, queued.p99 / 1e3, queued.p999 / 1e3, queued.max / 1e3);
+    std::printf("%-14s %10.1f %10.1f %10.1f %10.1f\n", "task started", at(0.5), at(0.99), at(0.999), late.back() / 1e3);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t samples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    // due within 5 minutes, most within the first seconds like per tick deadlines
+    std::mt19937_64 rng(7);
+    std::exponential_distribution<double> spread(1.0 / (2000.0 * MS));
+    const int64_t endNs = 300'000 * MS;
+    std::vector<int64_t> dues(count);
+    for (int64_t& due : dues) {
+        due = std::min<int64_t>(int64_t(spread(rng)), endNs);
+    }
+
+    std::printf("%zu timers, half cancelled, advanced in 1ms steps over %lld s\n\n", count, (long long)(endNs / 1000 / MS));
+    std::printf("%-14s %12s %12s %14s %10s\n", "container", "schedule ns", "cancel ns", "ns per fired", "fired");
+    OpCosts wheelCosts = wheel(dues, endNs);
+    OpCosts mapCosts = multimap(dues, endNs);
+    std::printf("%-14s %12.1f %12.1f %14.1f %10zu\n", "timer wheel", wheelCosts.schedule, wheelCosts.cancel, wheelCosts.advance, wheelCosts.fired);
+    std::printf("%-14s %12.1f %12.1f %14.1f %10zu\n", "multimap", mapCosts.schedule, mapCosts.cancel, mapCosts.advance, mapCosts.fired);
+
+    std::printf("\n%zu timers on a 2 worker pool, lateness in us\n", samples);
+    std::printf("%-14s %10s %10s %10s %10s\n", "", "p50", "p99", "p999", "max");
+    lateness(samples);
+
+    return wheelCosts.fired == mapCosts.fired ? 0 : 1;
+}
@@ -1,8 +1,13 @@
 #include "app.h"
 #include "discordBot.h"
 #include "investmentManager.h"
+#include "journal/streamJournal.h"
+#include "metrics/metricsServer.h"
+#include "metrics/metricsWriter.h"
 #include "taskManager.h"
+#include "utils/latencyMetrics.h"
 #include "utils/logger.h"
+#include "utils/timing.h"
 #include "nlohmann/json.hpp"
 #include <fstream>
 
@@ -23,6 +28,14 @@ static spdlog::level::level_enum to_spdlog_log_level(App::LogLevel level)
 App::App(const Spec& spec)
     : m_shouldRun(false)
     , m_reregisterDiscordBotSlashCommands(spec.reregisterDiscordBotSlashCommands)
+    , m_streamWorkerCount(spec.streamWorkerCount)
+    , m_partitionedStreamIngest(spec.partitionedStreamIngest)
+    , m_conflateStreamUpdates(spec.conflateStreamUpdates)
+    , m_taskWorkerCount(spec.taskWorkerCount)
+    , m_recordStreamJournal(spec.recordStreamJournal)
+    , m_streamJournalDir(spec.streamJournalDir)
+    , m_serveMetrics(spec.serveMetrics)
+    , m_metricsPort(spec.metricsPort)
 {
     // init logger
     Logger::init(to_spdlog_log_level(spec.logLevel));
@@ -98,16 +111,32 @@ void App::run()
 
     // investment manager
     m_investmentManager = std::make_unique<InvestmentManager>(
+        InvestmentManager::Spec{
+            .streamWorkerCount = m_streamWorkerCount,
+            .partitionedIngest = m_partitionedStreamIngest,
+            .conflateUpdates = m_conflateStreamUpdates,
+        },
         shared_from_this(),
         investmentManagerLogger
     );
 
     // task manager
     m_taskManager = std::make_unique<TaskManager>(
-        2,  // pool size
+        TaskManager::Spec{
+            .poolSize = m_taskWorkerCount,
+        },
         taskManagerLogger
     );
 
+    // stream journal
+    if (m_recordStreamJournal) {
+        m_streamJournal = std::make_unique<StreamJournal>(
+            m_streamJournalDir,
+            Logger::createWithSharedSinksAndLevel("StreamJournal")
+        );
+        m_streamJournal->run();
+    }
+
     // set the flag
     m_shouldRun = true;
 
@@ -158,15 +187,51 @@ void App::run()
         m_taskManager->run();
     }
 
+    // metrics, after the investment manager has published its partitions
+    if (m_serveMetrics) {
+        m_metricsServer = std::make_unique<MetricsServer>(
+            m_metricsPort,
+            std::bind(&App::collectMetrics, this, std::placeholders::_1),
+            Logger::createWithSharedSinksAndLevel("MetricsServer")
+        );
+        if (!m_metricsServer->run()) {
+            m_metricsServer.reset();
+        }
+    }
 
     // block
     std::unique_lock lock(m_mutex);
     m_cv.wait(lock, [this] { return !m_shouldRun; });
 
     // release these
-    m_taskManager.reset();
+    // no scrapes while the rest goes away
+    m_metricsServer.reset();
+    // the investment manager finishes the queued stream data first, which can still register tasks,
+    // the task manager then runs what is left while both are still around to call into
+    if (m_investmentManager) {
+        m_investmentManager->stop();
+    }
+    if (m_taskManager) {
+        m_taskManager->stop();
+    }
+
+    // every tick of the session has gone through the pipeline by now
+    for (size_t stage = 0; stage < size_t(LatencyStage::Count); ++stage) {
+        LatencySummary summary = LatencyMetrics::instance().summary(LatencyStage(stage));
+        if (summary.count > 0) {
+            LOG_INFO(
+                "Latency {}: {} samples, mean {:.1f}us, p50 {:.1f}us, p99 {:.1f}us, p999 {:.1f}us, max {:.1f}us",
+                toString(LatencyStage(stage)), summary.count, summary.mean / 1e3,
+                summary.p50 / 1e3, summary.p99 / 1e3, summary.p999 / 1e3, summary.max / 1e3
+            );
+        }
+    }
+
     m_investmentManager.reset();
+    m_taskManager.reset();
     m_schwabClient.reset();
+    // no more frames once the client is gone
+    m_streamJournal.reset();
     m_discordBot.reset();
 }
 
@@ -204,9 +269,16 @@ void App::onSchwabClientEvent(schwabcpp::Event& event)
 
 void App::streamerDataHandler(const std::string& data)
 {
+    int64_t receivedNs = monotonicNowNs();
+
+    // everything the streamer sends is recorded, market hours or not
+    if (m_streamJournal && !data.empty()) {
+        m_streamJournal->record(data);
+    }
+
     if (isMarketOpen()) {
         if (!data.empty()) {
-            m_investmentManager->enqueueStreamData(data);
+            m_investmentManager->enqueueStreamData(data, receivedNs);
         } else {
             LOG_DEBUG("Empty stream data.");
         }
@@ -215,6 +287,37 @@ void App::streamerDataHandler(const std::string& data)
     }
 }
 
+void App::collectMetrics(MetricsWriter& writer) const
+{
+    InvestmentManager::StreamIngestStats ingest = m_investmentManager->getStreamIngestStats();
+    InvestmentManager::RegistrationStats registration = m_investmentManager->getRegistrationStats();
+
+    writer.counter("stockbot_stream_frames_received_total", "Streamer frames handed to the investment manager.", ingest.framesReceived);
+    writer.counter("stockbot_stream_parse_errors_total", "Streamer frames that failed to decode.", ingest.parseErrors);
+    writer.counter("stockbot_stream_ticks_applied_total", "Level one updates applied to the stream data buffer.", ingest.updatesApplied);
+    writer.counter("stockbot_stream_ticks_conflated_total", "Level one updates merged into a pending update.", ingest.updatesConflated);
+    writer.counter("stockbot_tasks_deduplicated_total", "Updates of a symbol that already had a task scheduled.", ingest.tasksDeduplicated);
+
+    writer.gauge("stockbot_stream_queue_depth", "Raw frames waiting for a decoder.", ingest.streamQueueDepth);
+    writer.gauge("stockbot_partition_queue_depth", "Decoded updates waiting in the ingest partitions.", ingest.partitionQueueDepth);
+    writer.gauge("stockbot_registration_queue_depth", "Investments waiting for registration.", registration.pendingRegistrations);
+    writer.gauge("stockbot_task_queue_depth", "Tasks waiting for a worker.", m_taskManager->queuedCount());
+    uint64_t tasksExpired = 0;
+    for (size_t priority = 0; priority < size_t(TaskPriority::Count); ++priority) {
+        tasksExpired += m_taskManager->expiredCount(TaskPriority(priority));
+    }
+    writer.counter("stockbot_tasks_expired_total", "Tasks dropped because they were still queued at their deadline.", tasksExpired);
+    writer.gauge("stockbot_active_investments", "Registered auto investments.", registration.activeInvestments);
+    writer.gauge("stockbot_subscribed_symbols", "Symbols with at least one active investment.", registration.subscribedSymbols);
+
+    if (m_streamJournal) {
+        writer.counter("stockbot_journal_frames_recorded_total", "Frames written to the stream journal.", m_streamJournal->recordedCount());
+        writer.counter("stockbot_journal_frames_dropped_total", "Frames the stream journal had no room for.", m_streamJournal->droppedCount());
+    }
+
+    writer.latencyHistograms("stockbot_stage_latency_seconds", "Time spent by ticks in each pipeline stage.", LatencyMetrics::instance());
+}
+
 schwabcpp::AccountsSummaryMap
 App::getAccountSummary()
 {
@@ -230,13 +333,27 @@ void App::subscribeTickersToStream(const std::vector<std::string>& tickers)
             schwabcpp::StreamerField::LevelOneEquity::LowPrice,
             schwabcpp::StreamerField::LevelOneEquity::LastPrice,
             schwabcpp::StreamerField::LevelOneEquity::NetPercentChange,
+            // bars and volume indicators
+            schwabcpp::StreamerField::LevelOneEquity::TotalVolume,
+            schwabcpp::StreamerField::LevelOneEquity::LastSize,
+            schwabcpp::StreamerField::LevelOneEquity::TradeTime,
         }
     );
 }
 
-void App::registerTask(std::function<void()> task)
+void App::registerTask(Task task, const TaskOptions& options)
+{
+    m_taskManager->addTask(std::move(task), options);
+}
+
+TimerId App::scheduleTask(int64_t dueNs, Task task, const TaskOptions& options)
+{
+    return m_taskManager->addTimer(dueNs, std::move(task), options);
+}
+
+void App::cancelScheduledTask(TimerId id)
 {
-    m_taskManager->addTask(task);
+    m_taskManager->cancelTimer(id);
 }
 
 bool App::isMarketOpen() const
@@ -1,4 +1,5 @@
 #include "autoInvestment.h"
+#include "investmentHost.h"
 #include "schwabcpp/event/eventBase.h"
 #include "schwabcpp/schema/accountSummary.h"
 #include <filesystem>
@@ -12,9 +13,12 @@ namespace stockbot {
 
 class DiscordBot;
 class InvestmentManager;
+class MetricsServer;
+class MetricsWriter;
+class StreamJournal;
 class TaskManager;
 
-class App : public std::enable_shared_from_this<App>
+class App : public std::enable_shared_from_this<App>, public InvestmentHost
 {
     struct AccountInfo {
         std::string accountNumber;
@@ -32,6 +36,22 @@ public:
         std::filesystem::path   appCredentialPath = "./.appCredentials.json";
         LogLevel                logLevel = LogLevel::Debug;
         bool                    reregisterDiscordBotSlashCommands = false;
+
+        // -- Stream ingest
+        int                     streamWorkerCount = 2;
+        bool                    partitionedStreamIngest = true;    // per ticker ordering, see InvestmentManager::Spec
+        bool                    conflateStreamUpdates = false;     // partitioned ingest only
+
+        // -- Analysis tasks
+        int                     taskWorkerCount = 0;               // 0: hardware concurrency
+
+        // -- Stream journal, raw frames recorded for replay
+        bool                    recordStreamJournal = false;
+        std::filesystem::path   streamJournalDir = "./stockbot_data/journal";
+
+        // -- Prometheus metrics, served on 127.0.0.1 only
+        bool                    serveMetrics = false;
+        unsigned short          metricsPort = 9464;
     };
 
     App(const Spec& spec);
@@ -56,20 +76,24 @@ private:
     void                                stop();
 
 private:
-    // -- APIs for the investment manager to call
-    friend class InvestmentManager;
-    void                                subscribeTickersToStream(const std::vector<std::string>& tickers);
-    void                                registerTask(std::function<void()> task);
+    // -- InvestmentHost, for the investment manager to call
+    void                                subscribeTickersToStream(const std::vector<std::string>& tickers) override;
+    void                                registerTask(Task task, const TaskOptions& options) override;
+    TimerId                             scheduleTask(int64_t dueNs, Task task, const TaskOptions& options) override;
+    void                                cancelScheduledTask(TimerId id) override;
 
 private:
     // -- Convenience helpers
     bool                                isMarketOpen() const;
+    void                                collectMetrics(MetricsWriter& writer) const;
 
 private:
     std::unique_ptr<DiscordBot>         m_discordBot;
     std::unique_ptr<schwabcpp::Client>  m_schwabClient;
     std::unique_ptr<InvestmentManager>  m_investmentManager;
     std::unique_ptr<TaskManager>        m_taskManager;
+    std::unique_ptr<StreamJournal>      m_streamJournal;
+    std::unique_ptr<MetricsServer>      m_metricsServer;
 
     // -- State Management
     std::mutex                          m_mutex;
@@ -82,6 +106,14 @@ private:
     std::string                         m_schwabKey;
     std::string                         m_schwabSecret;
     bool                                m_reregisterDiscordBotSlashCommands;
+    int                                 m_streamWorkerCount;
+    bool                                m_partitionedStreamIngest;
+    bool                                m_conflateStreamUpdates;
+    int                                 m_taskWorkerCount;
+    bool                                m_recordStreamJournal;
+    std::filesystem::path               m_streamJournalDir;
+    bool                                m_serveMetrics;
+    unsigned short                      m_metricsPort;
 
     // -- Linked Accounts
     std::vector<AccountInfo>            m_linkedAccounts;
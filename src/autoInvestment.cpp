@@ -10,6 +10,8 @@ std::string AutoInvestment::freq_to_string(AutoInvestment::Frequency freq)
 
         case AutoInvestment::Unknown: return "Unknown";
     }
+    // not a Frequency value
+    return "Unknown";
 }
 
 AutoInvestment::Frequency AutoInvestment::string_to_frequency(const std::string& str)
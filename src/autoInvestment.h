@@ -15,23 +15,24 @@ struct AutoInvestment {
     std::string   ticker;
 
     std::vector<std::string>
-                  accounts;
+                  accounts{};
 
     enum Frequency {
         Daily,
         Weekly,
 
         Unknown,
-    }               frequency;
+    }               frequency = Unknown;
 
-    int             shares;   // # of shares to buy
-    int             extras;   // # of extra shares to add when the stock is down a tigger threshold and rebounced from previous low
+    int             shares = 0;   // # of shares to buy
+    int             extras = 0;   // # of extra shares to add when the stock is down a tigger threshold and rebounced from previous low
 
-    double          averageInThreshold;     // the threshold to average in extra shares when the stock is down
-    double          skipThreshold;          // the threshold to skip the purchase when the stock is up
+    double          averageInThreshold = 0.0;   // the threshold to average in extra shares when the stock is down
+    double          skipThreshold = 0.0;        // the threshold to skip the purchase when the stock is up
 
-    clock::rep      createdTime;
-    clock::rep      lastTriggerTime;
+    clock::rep      createdTime = 0;
+    clock::rep      lastTriggerTime = 0;    // committed by whatever acted on the window, see InvestmentManager::commitTrigger
+    clock::rep      signalledTime = 0;      // in memory only, the last time the rules signalled, never cached
 
     int             accumulatedShares = 0;
     double          accumulatedValue = 0.0;
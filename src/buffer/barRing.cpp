@@ -0,0 +1,116 @@
+#include "barRing.h"
+#include <algorithm>
+
+namespace stockbot {
+
+BarRing::BarRing(int64_t periodMs, size_t capacity)
+    : m_periodMs(std::max<int64_t>(periodMs, 1))
+    , m_capacity(std::max<size_t>(capacity, 1))
+    , m_slotCount(m_capacity + std::max<size_t>(m_capacity / 8, 1))
+    , m_timestamp(std::make_unique<std::atomic<int64_t>[]>(m_slotCount))
+    , m_open(std::make_unique<std::atomic<double>[]>(m_slotCount))
+    , m_high(std::make_unique<std::atomic<double>[]>(m_slotCount))
+    , m_low(std::make_unique<std::atomic<double>[]>(m_slotCount))
+    , m_close(std::make_unique<std::atomic<double>[]>(m_slotCount))
+    , m_volume(std::make_unique<std::atomic<double>[]>(m_slotCount))
+    , m_count(std::make_unique<std::atomic<uint32_t>[]>(m_slotCount))
+{
+    static_assert(std::atomic<double>::is_always_lock_free, "the bar columns must be plain loads and stores");
+}
+
+void BarRing::addTrade(int64_t timeMs, double price, double size)
+{
+    int64_t start = timeMs - timeMs % m_periodMs;
+
+    if (m_building.count == 0 || start > m_building.timestamp) {
+        if (m_building.count > 0) {
+            close(m_building);
+        }
+        m_building = Bar{
+            .timestamp = start,
+            .open = price,
+            .high = price,
+            .low = price,
+            .close = price,
+            .volume = size,
+            .count = 1,
+        };
+    } else {
+        m_building.high = std::max(m_building.high, price);
+        m_building.low = std::min(m_building.low, price);
+        if (start == m_building.timestamp) {
+            m_building.close = price;
+        }
+        m_building.volume += size;
+        ++m_building.count;
+    }
+
+    m_current.store(m_building);
+}
+
+void BarRing::close(const Bar& bar)
+{
+    uint64_t closed = m_closedCount.load(std::memory_order_relaxed);
+    size_t slot = closed % m_slotCount;
+    // a reader that copies any of the values below also sees the closed count before this bar,
+    // so it can tell the slot was reused
+    std::atomic_thread_fence(std::memory_order_release);
+    m_timestamp[slot].store(bar.timestamp, std::memory_order_relaxed);
+    m_open[slot].store(bar.open, std::memory_order_relaxed);
+    m_high[slot].store(bar.high, std::memory_order_relaxed);
+    m_low[slot].store(bar.low, std::memory_order_relaxed);
+    m_close[slot].store(bar.close, std::memory_order_relaxed);
+    m_volume[slot].store(bar.volume, std::memory_order_relaxed);
+    m_count[slot].store(bar.count, std::memory_order_relaxed);
+
+    // the slot is complete before readers can see it
+    m_closedCount.store(closed + 1, std::memory_order_release);
+}
+
+size_t BarRing::latest(size_t maxBars, BarColumns& out) const
+{
+    // Slots are reused once the ring wraps. The ring has an eighth more slots than the readers
+    // get, so the writer has to close that many bars during one copy to catch up with the reader.
+    uint64_t closed = closedCount();
+    size_t count = static_cast<size_t>(std::min<uint64_t>({ closed, maxBars, m_capacity }));
+    uint64_t first = closed - count;
+
+    auto copyColumn = [&](auto& column, const auto& ring) {
+        column.resize(count);
+        size_t slot = first % m_slotCount;
+        for (size_t i = 0; i < count; ++i) {
+            column[i] = ring[slot].load(std::memory_order_relaxed);
+            if (++slot == m_slotCount) {
+                slot = 0;
+            }
+        }
+    };
+    copyColumn(out.timestamp, m_timestamp);
+    copyColumn(out.open, m_open);
+    copyColumn(out.high, m_high);
+    copyColumn(out.low, m_low);
+    copyColumn(out.close, m_close);
+    copyColumn(out.volume, m_volume);
+    copyColumn(out.count, m_count);
+
+    // Drop the bars overwritten while copying. The writer may be filling the slot of bar number
+    // after already, which held bar after - m_slotCount. Pairs with the fence in close().
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = m_closedCount.load(std::memory_order_relaxed);
+    if (after + 1 > first + m_slotCount) {
+        size_t stale = static_cast<size_t>(std::min<uint64_t>(after + 1 - m_slotCount - first, count));
+        auto dropFront = [stale](auto& column) { column.erase(column.begin(), column.begin() + stale); };
+        dropFront(out.timestamp);
+        dropFront(out.open);
+        dropFront(out.high);
+        dropFront(out.low);
+        dropFront(out.close);
+        dropFront(out.volume);
+        dropFront(out.count);
+        count -= stale;
+    }
+
+    return count;
+}
+
+} // namespace stockbot
@@ -0,0 +1,103 @@
+#ifndef __BAR_RING_H__
+#define __BAR_RING_H__
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "utils/seqLock.h"
+
+namespace stockbot {
+
+struct Bar {
+    int64_t                         timestamp = 0;  // bar start, epoch ms
+    double                          open = std::numeric_limits<double>::quiet_NaN();
+    double                          high = std::numeric_limits<double>::quiet_NaN();
+    double                          low = std::numeric_limits<double>::quiet_NaN();
+    double                          close = std::numeric_limits<double>::quiet_NaN();
+    double                          volume = 0.0;
+    uint32_t                        count = 0;      // trades, 0 means no bar yet
+};
+
+// Bars copied out of a BarRing, one contiguous array per field, oldest first. Reuse it between
+// reads, the vectors keep their capacity.
+struct BarColumns {
+    std::vector<int64_t>            timestamp;
+    std::vector<double>             open;
+    std::vector<double>             high;
+    std::vector<double>             low;
+    std::vector<double>             close;
+    std::vector<double>             volume;
+    std::vector<uint32_t>           count;
+
+    size_t                          size() const { return close.size(); }
+};
+
+// Fixed capacity OHLC bars of one period, stored as a structure of arrays.
+//
+// Closed bars are written once to the column arrays and published by bumping the closed count,
+// the bar being built is published through a seqlock. The columns are atomic like the words of
+// SeqLock, a reader copying a slot the writer reuses gets a stale value, not a data race, and
+// drops it. Readers never block the writer. Periods without trades have no bar, the timestamps
+// tell the gaps. Nothing allocates after construction.
+//
+// Single writer, the caller serializes addTrade().
+class BarRing
+{
+public:
+    // the ring has an eighth more slots than capacity, see latest()
+                                    BarRing(int64_t periodMs, size_t capacity);
+
+    // -- writer
+    // A trade older than the current bar (out of order delivery) is folded into the current bar
+    // without moving its close.
+    void                            addTrade(int64_t timeMs, double price, double size);
+
+    // -- readers
+    int64_t                         periodMs() const { return m_periodMs; }
+    size_t                          capacity() const { return m_capacity; }
+
+    // bars closed since construction, readers get the latest capacity() of them
+    uint64_t                        closedCount() const { return m_closedCount.load(std::memory_order_acquire); }
+
+    // the bar still being built, count is 0 before the first trade
+    Bar                             current() const { return m_current.load(); }
+
+    // Copies up to maxBars of the latest closed bars to out, oldest first, and returns how many.
+    // out is overwritten.
+    size_t                          latest(size_t maxBars, BarColumns& out) const;
+
+private:
+    void                            close(const Bar& bar);
+
+private:
+    const int64_t                   m_periodMs;
+    const size_t                    m_capacity;
+    const size_t                    m_slotCount;    // capacity plus the slots the writer may be reusing
+
+    // -- closed bars, slot = bar number % m_slotCount
+    std::unique_ptr<std::atomic<int64_t>[]>
+                                    m_timestamp;
+    std::unique_ptr<std::atomic<double>[]>
+                                    m_open;
+    std::unique_ptr<std::atomic<double>[]>
+                                    m_high;
+    std::unique_ptr<std::atomic<double>[]>
+                                    m_low;
+    std::unique_ptr<std::atomic<double>[]>
+                                    m_close;
+    std::unique_ptr<std::atomic<double>[]>
+                                    m_volume;
+    std::unique_ptr<std::atomic<uint32_t>[]>
+                                    m_count;
+    std::atomic<uint64_t>           m_closedCount = 0;
+
+    // -- bar being built
+    Bar                             m_building;     // writer's copy
+    SeqLock<Bar>                    m_current;
+};
+
+} // namespace stockbot
+
+#endif
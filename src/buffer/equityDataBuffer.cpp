@@ -1,13 +1,17 @@
 #include "equityDataBuffer.h"
+#include <cmath>
 
 namespace stockbot {
 
 EquityDataBuffer::EquityDataBuffer(const std::string& symbol)
     : m_symbol(symbol)
-    , m_lod(std::numeric_limits<double>::quiet_NaN())
-    , m_hod(std::numeric_limits<double>::quiet_NaN())
-    , m_netPercentChange(std::numeric_limits<double>::quiet_NaN())
-    , m_lastPrice(std::numeric_limits<double>::quiet_NaN())
+    , m_seq(0)
+    , m_indicators(IndicatorSet::Spec{})
+    , m_bars{
+        BarRing(1000, ONE_SECOND_BAR_CAPACITY),
+        BarRing(60 * 1000, ONE_MINUTE_BAR_CAPACITY),
+        BarRing(5 * 60 * 1000, FIVE_MINUTE_BAR_CAPACITY),
+    }
 {
 
 }
@@ -17,41 +21,76 @@ EquityDataBuffer::~EquityDataBuffer()
 
 }
 
-void EquityDataBuffer::addLevelOneData(const std::unordered_map<schwabcpp::StreamerField::LevelOneEquity, double>& fields)
+bool EquityDataBuffer::tryScheduleTask()
+{
+    // Always a read-modify-write, even to leave it dirty: it orders this update with the task
+    // finishing, which then either reads it or sees the dirty mark.
+    uint8_t state = TaskIdle;
+    while (!m_taskState.compare_exchange_weak(state, state == TaskIdle ? TaskScheduled : TaskDirty,
+                                              std::memory_order_acq_rel, std::memory_order_relaxed)) {}
+    return state == TaskIdle;
+}
+
+bool EquityDataBuffer::finishTask()
+{
+    uint8_t state = TaskScheduled;
+    while (!m_taskState.compare_exchange_weak(state, state == TaskDirty ? TaskScheduled : TaskIdle,
+                                              std::memory_order_acq_rel, std::memory_order_relaxed)) {}
+    return state == TaskDirty;
+}
+
+void EquityDataBuffer::addLevelOneData(const LevelOneFieldSet& fields)
+{
+    using Field = schwabcpp::StreamerField::LevelOneEquity;
+
+    // the seqlock needs a single writer at a time
+    std::lock_guard lock(m_writeMutex);
+
+    // fields that are not in this update keep their previous values
+    double previousVolume = m_levelOneData.get(Field::TotalVolume);
+    m_levelOneData.merge(fields);
+
+    // a new last price or volume means trades happened since the previous update
+    if (fields.has(Field::LastPrice) || fields.has(Field::TotalVolume)) {
+        addTrade(fields, previousVolume);
+    }
+
+    m_quote.store({
+        .lastPrice = m_levelOneData.get(Field::LastPrice),
+        .lod = m_levelOneData.get(Field::LowPrice),
+        .hod = m_levelOneData.get(Field::HighPrice),
+        .netPercentChange = m_levelOneData.get(Field::NetPercentChange),
+        .seq = ++m_seq,
+        .timestamp = schwabcpp::clock::now().time_since_epoch().count(),
+    });
+}
+
+void EquityDataBuffer::addTrade(const LevelOneFieldSet& fields, double previousVolume)
 {
-    // this entire function should be protected
-    std::lock_guard lock(m_mutex);
-
-    for (const auto& [field, value] : fields) {
-        switch (field) {
-
-            case schwabcpp::StreamerField::LevelOneEquity::LowPrice:
-            {
-                m_lod = value;
-                break;
-            }
-
-            case schwabcpp::StreamerField::LevelOneEquity::HighPrice:
-            {
-                m_hod = value;
-                break;
-            }
-
-            case schwabcpp::StreamerField::LevelOneEquity::LastPrice:
-            {
-                m_lastPrice = value;
-                break;
-            }
-
-            case schwabcpp::StreamerField::LevelOneEquity::NetPercentChange:
-            {
-                m_netPercentChange = value;
-                break;
-            }
-
-            default: break;
-        }
+    using Field = schwabcpp::StreamerField::LevelOneEquity;
+
+    double price = m_levelOneData.get(Field::LastPrice);
+    if (std::isnan(price)) {
+        return;
     }
+
+    // the volume delta covers every trade since the previous update, the last size only the last one
+    double volume = m_levelOneData.get(Field::TotalVolume) - previousVolume;
+    if (std::isnan(volume) || volume < 0.0) {
+        volume = fields.has(Field::LastSize) ? fields.get(Field::LastSize) : 0.0;
+    }
+
+    // exchange time when the update has one, so replays build the same bars
+    int64_t timeMs = fields.has(Field::TradeTime)
+        ? static_cast<int64_t>(fields.get(Field::TradeTime))
+        : std::chrono::duration_cast<std::chrono::milliseconds>(schwabcpp::clock::now().time_since_epoch()).count();
+
+    for (BarRing& bars : m_bars) {
+        bars.addTrade(timeMs, price, volume);
+    }
+
+    m_indicators.update(timeMs, price, volume);
+    m_indicatorValues.store(m_indicators.values());
 }
 
 }
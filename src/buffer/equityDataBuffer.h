@@ -1,42 +1,92 @@
 #ifndef __EQUITY_DATA_BUFFER__
 #define __EQUITY_DATA_BUFFER__
 
+#include <array>
+#include <atomic>
 #include <string>
 #include <mutex>
-#include <unordered_map>
-#include "schwabcpp/streamerField.h"
+#include "barRing.h"
+#include "levelOneFieldSet.h"
+#include "indicator/indicatorSet.h"
+#include "schwabcpp/utils/clock.h"
+#include "utils/ringQueue.h"
+#include "utils/seqLock.h"
 
 namespace stockbot {
 
+// consistent view of the quote, always read as a whole
+struct EquityQuote {
+    double                          lastPrice = std::numeric_limits<double>::quiet_NaN();
+    double                          lod = std::numeric_limits<double>::quiet_NaN();
+    double                          hod = std::numeric_limits<double>::quiet_NaN();
+    double                          netPercentChange = std::numeric_limits<double>::quiet_NaN();
+    uint64_t                        seq = 0;        // number of updates applied, 0 means no data yet
+    schwabcpp::clock::rep           timestamp = 0;  // when the latest update was applied
+};
+
+enum class BarPeriod : char {
+    OneSecond,
+    OneMinute,
+    FiveMinutes,
+
+    Count,
+};
+
 class EquityDataBuffer {
 public:
+    // Bars are sized for a whole trading day: the regular session at 1s, 4:00 - 20:00 at 1m / 5m.
+    // The rings add an eighth for the slots being reused (see BarRing::latest). About 1.4MB per
+    // symbol, allocated with the buffer.
+    static constexpr size_t         ONE_SECOND_BAR_CAPACITY = 390 * 60;
+    static constexpr size_t         ONE_MINUTE_BAR_CAPACITY = 16 * 60;
+    static constexpr size_t         FIVE_MINUTE_BAR_CAPACITY = 16 * 12;
+
                                     EquityDataBuffer(const std::string& symbol);
                                     ~EquityDataBuffer();
 
-    void                            addLevelOneData(const std::unordered_map<schwabcpp::StreamerField::LevelOneEquity, double>& fields);
+    void                            addLevelOneData(const LevelOneFieldSet& fields);
 
-    [[nodiscard]]
-    std::lock_guard<std::mutex>     lockForAccess() { return std::lock_guard(m_mutex); }
+    // lock free, never blocks the writers
+    EquityQuote                     snapshot() const { return m_quote.load(); }
 
+    // OHLC of the trades, lock free like snapshot()
+    const BarRing&                  bars(BarPeriod period) const { return m_bars[size_t(period)]; }
 
-    // -- getters (these are not thread safe, lock the buffer before calling them)
-    double                          getLastPrice() const { return m_lastPrice; }
+    // indicators of the trades, updated with every trade, lock free like snapshot()
+    IndicatorValues                 indicators() const { return m_indicatorValues.load(); }
 
-    double                          getLOD() const { return m_lod; }
+    const std::string&              getSymbol() const { return m_symbol; }
 
-    double                          getHOD() const { return m_hod; }
+    // -- the analysis task of the symbol, at most one pending or running at a time
+    // Called after an update. True when no task was scheduled and the caller schedules one,
+    // otherwise the pending task is marked dirty. One CAS.
+    bool                            tryScheduleTask();
+    // Called by the task after it read the buffer. True when updates came in since it was
+    // scheduled or last read, the task reads again. False and the next update schedules anew.
+    bool                            finishTask();
 
-    double                          getNetPercentChange() const { return m_netPercentChange; }
+private:
+    void                            addTrade(const LevelOneFieldSet& fields, double previousVolume);
 
 private:
     std::string                     m_symbol;
 
-    // -- directly from stream data, needs mutex
-    double                          m_lod;
-    double                          m_hod;
-    double                          m_netPercentChange;
-    double                          m_lastPrice;
-    std::mutex                      m_mutex;
+    // -- directly from stream data, only touched by the writers
+    LevelOneFieldSet                m_levelOneData;
+    uint64_t                        m_seq;
+    IndicatorSet                    m_indicators;
+    std::mutex                      m_writeMutex;   // writers only, readers go through m_quote
+
+    // -- published to the readers
+    SeqLock<EquityQuote>            m_quote;
+    std::array<BarRing, size_t(BarPeriod::Count)>
+                                    m_bars;
+    SeqLock<IndicatorValues>        m_indicatorValues;
+
+    // TaskState, written on every tick, kept away from what the readers load
+    enum TaskState : uint8_t { TaskIdle, TaskScheduled, TaskDirty };
+    alignas(CACHE_LINE_SIZE) std::atomic<uint8_t>
+                                    m_taskState = TaskIdle;
 };
 
 } // namespace stockbot
@@ -0,0 +1,78 @@
+#ifndef __LEVEL_ONE_FIELD_SET__
+#define __LEVEL_ONE_FIELD_SET__
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include "schwabcpp/streamerField.h"
+
+namespace stockbot {
+
+// Fixed layout set of LEVELONE_EQUITIES field values.
+//
+// Values are stored in an array indexed by the field (the LevelOneEquity enumerators are the
+// streamer field numbers) and a bitmask tracks which ones are present. Lives on the stack and
+// copies as a flat block, nothing here ever allocates.
+class LevelOneFieldSet
+{
+    using Field = schwabcpp::StreamerField::LevelOneEquity;
+public:
+    // LEVELONE_EQUITIES defines fields 0 - 51
+    static constexpr size_t         CAPACITY = 52;
+
+    // fields outside of the capacity are dropped
+    void                            set(Field field, double value)
+                                    {
+                                        size_t index = static_cast<size_t>(field);
+                                        if (index < CAPACITY) {
+                                            m_values[index] = value;
+                                            m_mask |= bit(index);
+                                        }
+                                    }
+
+    bool                            has(Field field) const
+                                    {
+                                        size_t index = static_cast<size_t>(field);
+                                        return index < CAPACITY && (m_mask & bit(index));
+                                    }
+
+    // NaN if the field is not present
+    double                          get(Field field) const
+                                    {
+                                        return has(field) ? m_values[static_cast<size_t>(field)] : std::numeric_limits<double>::quiet_NaN();
+                                    }
+
+    // overwrites with every field present in other, the rest are kept
+    void                            merge(const LevelOneFieldSet& other)
+                                    {
+                                        other.forEach([this](Field field, double value) { set(field, value); });
+                                    }
+
+    void                            clear() { m_mask = 0; }
+
+    bool                            empty() const { return m_mask == 0; }
+    size_t                          size() const { return std::popcount(m_mask); }
+    uint64_t                        mask() const { return m_mask; }
+
+    // fn(Field, double) for every present field in field order
+    template <typename Fn>
+    void                            forEach(Fn&& fn) const
+                                    {
+                                        for (uint64_t remaining = m_mask; remaining; remaining &= remaining - 1) {
+                                            size_t index = std::countr_zero(remaining);
+                                            fn(static_cast<Field>(index), m_values[index]);
+                                        }
+                                    }
+
+private:
+    static constexpr uint64_t       bit(size_t index) { return uint64_t(1) << index; }
+
+private:
+    uint64_t                        m_mask = 0;
+    std::array<double, CAPACITY>    m_values{};
+};
+
+} // namespace stockbot
+
+#endif
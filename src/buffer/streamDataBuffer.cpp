@@ -4,6 +4,7 @@
 namespace stockbot {
 
 StreamDataBuffer::StreamDataBuffer()
+    : m_slots(std::make_unique<Slot[]>(SymbolTable::MAX_SYMBOLS))
 {
 
 }
@@ -13,22 +14,37 @@ StreamDataBuffer::~StreamDataBuffer()
 
 }
 
-std::weak_ptr<EquityDataBuffer>
-StreamDataBuffer::addLevelOneEquityData(const std::string& ticker,
-                                        const std::unordered_map<schwabcpp::StreamerField::LevelOneEquity, double>& fields)
+const std::shared_ptr<EquityDataBuffer>&
+StreamDataBuffer::registerSymbol(SymbolId symbol)
 {
-    std::shared_ptr<EquityDataBuffer> targetBuffer;
-    {
-        std::lock_guard lock(m_mutex);
-        if (!m_equityDataBuffers.contains(ticker)) {
-            m_equityDataBuffers[ticker] = std::make_shared<EquityDataBuffer>(ticker);
-        }
-        targetBuffer = m_equityDataBuffers[ticker];
-    }
+    Slot& slot = m_slots[symbol];
+    return slot.ready.load(std::memory_order_acquire) ? slot.buffer : getOrCreate(symbol);
+}
+
+const std::shared_ptr<EquityDataBuffer>&
+StreamDataBuffer::addLevelOneEquityData(SymbolId symbol,
+                                        const LevelOneFieldSet& fields)
+{
+    Slot& slot = m_slots[symbol];
+    const std::shared_ptr<EquityDataBuffer>& targetBuffer = slot.ready.load(std::memory_order_acquire) ? slot.buffer : getOrCreate(symbol);
 
     targetBuffer->addLevelOneData(fields);
 
     return targetBuffer;
 }
 
+const std::shared_ptr<EquityDataBuffer>&
+StreamDataBuffer::getOrCreate(SymbolId symbol)
+{
+    Slot& slot = m_slots[symbol];
+
+    std::lock_guard lock(m_mutex);
+    if (!slot.ready.load(std::memory_order_relaxed)) {
+        slot.buffer = std::make_shared<EquityDataBuffer>(SymbolTable::instance().name(symbol));
+        slot.ready.store(true, std::memory_order_release);
+    }
+
+    return slot.buffer;
+}
+
 }
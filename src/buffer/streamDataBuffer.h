@@ -1,30 +1,50 @@
 #ifndef __STREAM_DATA_BUFFER__
 #define __STREAM_DATA_BUFFER__
 
+#include <atomic>
 #include <mutex>
 #include <memory>
-#include <unordered_map>
-#include "schwabcpp/streamerField.h"
+#include "levelOneFieldSet.h"
+#include "utils/symbolTable.h"
 
 namespace stockbot {
 
 class EquityDataBuffer;
 
+// Registry of the per ticker buffers.
+//
+// Slots are indexed by SymbolId and pre-sized for the whole symbol table. A slot is filled once,
+// normally when the symbol is registered, and is immutable afterwards, so the tick path finds its
+// buffer with a single acquire load and no lock.
 class StreamDataBuffer
 {
+    struct Slot {
+        std::atomic<bool>                   ready = false;
+        std::shared_ptr<EquityDataBuffer>   buffer;         // written once before ready is set
+    };
+
 public:
                                             StreamDataBuffer();
                                             ~StreamDataBuffer();
 
-    // Returns a weak reference to the buffer which the data was added to
-    [[nodiscard]]
-    std::weak_ptr<EquityDataBuffer>         addLevelOneEquityData(const std::string& ticker,
-                                                                  const std::unordered_map<schwabcpp::StreamerField::LevelOneEquity, double>& fields);
+    // Creates the buffer for the symbol ahead of its first tick, no-op if it exists. The
+    // returned references stay valid as long as the registry, a slot is never emptied.
+    const std::shared_ptr<EquityDataBuffer>&
+                                            registerSymbol(SymbolId symbol);
+
+    // Returns the buffer which the data was added to
+    const std::shared_ptr<EquityDataBuffer>&
+                                            addLevelOneEquityData(SymbolId symbol,
+                                                                  const LevelOneFieldSet& fields);
+
+private:
+    // slow path, only taken for symbols that were not registered beforehand
+    const std::shared_ptr<EquityDataBuffer>&
+                                            getOrCreate(SymbolId symbol);
 
 private:
-    std::mutex                              m_mutex;
-    std::unordered_map<std::string, std::shared_ptr<EquityDataBuffer>>
-                                            m_equityDataBuffers;
+    std::unique_ptr<Slot[]>                 m_slots;        // indexed by SymbolId
+    std::mutex                              m_mutex;        // serializes slot creation only
 };
 
 } // namespace stockbot
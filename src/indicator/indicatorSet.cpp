@@ -0,0 +1,43 @@
+#include "indicatorSet.h"
+
+namespace stockbot {
+
+IndicatorSet::IndicatorSet(const Spec& spec)
+    : m_spec(spec)
+    , m_fastEma(spec.fastEmaPeriod)
+    , m_slowEma(spec.slowEmaPeriod)
+    , m_stats(spec.statsWindow)
+    , m_extrema(spec.extremaWindow)
+{
+}
+
+void IndicatorSet::update(int64_t timeMs, double price, double volume)
+{
+    if (m_lastTimeMs != std::numeric_limits<int64_t>::min() && timeMs - m_lastTimeMs >= m_spec.sessionGapMs) {
+        m_vwap.reset();
+    }
+    m_lastTimeMs = std::max(m_lastTimeMs, timeMs);
+
+    m_fastEma.update(price);
+    m_slowEma.update(price);
+    m_stats.update(price);
+    m_extrema.update(price);
+    m_vwap.update(price, volume);
+
+    double low = m_extrema.min();
+    double high = m_extrema.max();
+    m_values = IndicatorValues{
+        .fastEma = m_fastEma.value(),
+        .slowEma = m_slowEma.value(),
+        .sma = m_stats.mean(),
+        .stdDev = m_stats.stdDev(),
+        .vwap = m_vwap.value(),
+        .windowLow = low,
+        .windowHigh = high,
+        .drawdown = high > 0.0 ? (high - price) / high : 0.0,
+        .rebound = low > 0.0 ? (price - low) / low : 0.0,
+        .updates = m_values.updates + 1,
+    };
+}
+
+} // namespace stockbot
@@ -0,0 +1,57 @@
+#ifndef __INDICATOR_SET_H__
+#define __INDICATOR_SET_H__
+
+#include "indicators.h"
+#include <cstdint>
+#include <limits>
+
+namespace stockbot {
+
+// indicator values after one update, read as a whole
+struct IndicatorValues {
+    double                          fastEma = std::numeric_limits<double>::quiet_NaN();
+    double                          slowEma = std::numeric_limits<double>::quiet_NaN();
+    double                          sma = std::numeric_limits<double>::quiet_NaN();             // -- over statsWindow
+    double                          stdDev = std::numeric_limits<double>::quiet_NaN();
+    double                          vwap = std::numeric_limits<double>::quiet_NaN();            // session
+    double                          windowLow = std::numeric_limits<double>::quiet_NaN();       // -- over extremaWindow
+    double                          windowHigh = std::numeric_limits<double>::quiet_NaN();
+    double                          drawdown = std::numeric_limits<double>::quiet_NaN();        // fraction below windowHigh
+    double                          rebound = std::numeric_limits<double>::quiet_NaN();         // fraction above windowLow
+    uint64_t                        updates = 0;    // trades seen, 0 means no data yet
+};
+
+// The indicators an equity buffer keeps up to date with every trade. Windows count trades.
+class IndicatorSet
+{
+public:
+    struct Spec {
+        size_t                      fastEmaPeriod = 12;
+        size_t                      slowEmaPeriod = 26;
+        size_t                      statsWindow = 300;
+        size_t                      extremaWindow = 1000;
+        // a gap this long between two trades starts a new session, the VWAP restarts
+        int64_t                     sessionGapMs = 4 * 60 * 60 * 1000;
+    };
+
+    explicit                        IndicatorSet(const Spec& spec);
+
+    void                            update(int64_t timeMs, double price, double volume);
+
+    const IndicatorValues&          values() const { return m_values; }
+
+private:
+    Spec                            m_spec;
+    Ema                             m_fastEma;
+    Ema                             m_slowEma;
+    RollingStats                    m_stats;
+    RollingMinMax                   m_extrema;
+    Vwap                            m_vwap;
+    int64_t                         m_lastTimeMs = std::numeric_limits<int64_t>::min();
+
+    IndicatorValues                 m_values;
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef __INDICATORS_H__
+#define __INDICATORS_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace stockbot {
+
+// Incremental indicators over a stream of values.
+//
+// Every update is O(1) and nothing allocates after construction: windows are counted in
+// updates and their storage is sized once. Values read before the first update are NaN.
+
+// fixed capacity ring of the latest values, the building block of the windowed indicators
+template <typename T>
+class WindowRing
+{
+public:
+    explicit                        WindowRing(size_t capacity)
+                                        : m_capacity(std::max<size_t>(capacity, 1))
+                                        , m_values(std::make_unique<T[]>(m_capacity))
+                                    {}
+
+    size_t                          size() const { return m_size; }
+    size_t                          capacity() const { return m_capacity; }
+    bool                            full() const { return m_size == m_capacity; }
+    bool                            empty() const { return m_size == 0; }
+
+    const T&                        front() const { return m_values[m_head]; }
+    const T&                        back() const { return m_values[slot(m_size - 1)]; }
+
+    // the caller checks full() first
+    void                            pushBack(const T& value)
+                                    {
+                                        m_values[slot(m_size)] = value;
+                                        ++m_size;
+                                    }
+    void                            popFront() { m_head = slot(1); --m_size; }
+    void                            popBack() { --m_size; }
+
+    void                            clear() { m_head = 0; m_size = 0; }
+
+private:
+    // offset < capacity, a compare is cheaper than a modulo by a runtime capacity
+    size_t                          slot(size_t offset) const
+                                    {
+                                        size_t index = m_head + offset;
+                                        return index >= m_capacity ? index - m_capacity : index;
+                                    }
+
+private:
+    size_t                          m_capacity;
+    std::unique_ptr<T[]>            m_values;
+    size_t                          m_head = 0;
+    size_t                          m_size = 0;
+};
+
+// exponential moving average, seeded with the first value
+class Ema
+{
+public:
+    explicit                        Ema(size_t period) : m_alpha(2.0 / (std::max<size_t>(period, 1) + 1.0)) {}
+
+    void                            update(double value) { m_value = std::isnan(m_value) ? value : m_value + m_alpha * (value - m_value); }
+    double                          value() const { return m_value; }
+    void                            reset() { m_value = std::numeric_limits<double>::quiet_NaN(); }
+
+private:
+    double                          m_alpha;
+    double                          m_value = std::numeric_limits<double>::quiet_NaN();
+};
+
+// Mean and standard deviation of the latest window values, Welford updates with the oldest value
+// replaced once the window is full. The mean doubles as the simple moving average.
+class RollingStats
+{
+public:
+    explicit                        RollingStats(size_t window) : m_window(window) {}
+
+    void                            update(double value)
+                                    {
+                                        if (!m_window.full()) {
+                                            m_window.pushBack(value);
+                                            double delta = value - m_mean;
+                                            m_mean += delta / m_window.size();
+                                            m_m2 += delta * (value - m_mean);
+                                            return;
+                                        }
+
+                                        double oldest = m_window.front();
+                                        m_window.popFront();
+                                        m_window.pushBack(value);
+                                        double oldMean = m_mean;
+                                        m_mean += (value - oldest) / m_window.size();
+                                        m_m2 += (value - oldest) * (value - m_mean + oldest - oldMean);
+                                        // rounding can take it just under zero when the window is flat
+                                        m_m2 = std::max(m_m2, 0.0);
+                                    }
+
+    size_t                          count() const { return m_window.size(); }
+    double                          mean() const { return m_window.empty() ? std::numeric_limits<double>::quiet_NaN() : m_mean; }
+    // population variance over the window
+    double                          variance() const { return m_window.empty() ? std::numeric_limits<double>::quiet_NaN() : m_m2 / m_window.size(); }
+    double                          stdDev() const { return std::sqrt(variance()); }
+
+    void                            reset() { m_window.clear(); m_mean = 0.0; m_m2 = 0.0; }
+
+private:
+    WindowRing<double>              m_window;
+    double                          m_mean = 0.0;
+    double                          m_m2 = 0.0;
+};
+
+// Minimum and maximum of the latest window values with monotonic deques: each value is pushed
+// and popped at most once per deque, so updates are amortized O(1).
+class RollingMinMax
+{
+    struct Entry {
+        uint64_t                    index;
+        double                      value;
+    };
+
+public:
+    explicit                        RollingMinMax(size_t window)
+                                        : m_windowSize(std::max<size_t>(window, 1))
+                                        , m_min(m_windowSize)
+                                        , m_max(m_windowSize)
+                                    {}
+
+    void                            update(double value)
+                                    {
+                                        uint64_t index = m_count++;
+                                        push(m_min, { index, value }, [](double back, double v) { return back >= v; });
+                                        push(m_max, { index, value }, [](double back, double v) { return back <= v; });
+                                    }
+
+    double                          min() const { return m_min.empty() ? std::numeric_limits<double>::quiet_NaN() : m_min.front().value; }
+    double                          max() const { return m_max.empty() ? std::numeric_limits<double>::quiet_NaN() : m_max.front().value; }
+
+    void                            reset() { m_min.clear(); m_max.clear(); m_count = 0; }
+
+private:
+    // dominated drops the entries at the back the new value makes irrelevant
+    template <typename Dominated>
+    void                            push(WindowRing<Entry>& deque, Entry entry, Dominated dominated)
+                                    {
+                                        while (!deque.empty() && dominated(deque.back().value, entry.value)) {
+                                            deque.popBack();
+                                        }
+                                        // out of the window
+                                        if (!deque.empty() && deque.front().index + m_windowSize <= entry.index) {
+                                            deque.popFront();
+                                        }
+                                        deque.pushBack(entry);
+                                    }
+
+private:
+    size_t                          m_windowSize;
+    WindowRing<Entry>               m_min;
+    WindowRing<Entry>               m_max;
+    uint64_t                        m_count = 0;
+};
+
+// volume weighted average price since the last reset
+class Vwap
+{
+public:
+    void                            update(double price, double volume)
+                                    {
+                                        if (volume > 0.0) {
+                                            m_notional += price * volume;
+                                            m_volume += volume;
+                                        }
+                                    }
+
+    double                          value() const { return m_volume > 0.0 ? m_notional / m_volume : std::numeric_limits<double>::quiet_NaN(); }
+    void                            reset() { m_notional = 0.0; m_volume = 0.0; }
+
+private:
+    double                          m_notional = 0.0;
+    double                          m_volume = 0.0;
+};
+
+} // namespace stockbot
+
+#endif
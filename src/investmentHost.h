@@ -0,0 +1,26 @@
+#ifndef __INVESTMENT_HOST_H__
+#define __INVESTMENT_HOST_H__
+
+#include "taskOptions.h"
+#include <string>
+#include <vector>
+
+namespace stockbot {
+
+// What the investment manager needs from its owner. The App implements it on top of the Schwab
+// client and the task manager, offline tools provide their own.
+class InvestmentHost
+{
+public:
+    virtual                             ~InvestmentHost() = default;
+
+    virtual void                        subscribeTickersToStream(const std::vector<std::string>& tickers) = 0;
+    virtual void                        registerTask(Task task, const TaskOptions& options) = 0;
+    // registers the task once monotonicNowNs() reaches dueNs
+    virtual TimerId                     scheduleTask(int64_t dueNs, Task task, const TaskOptions& options) = 0;
+    virtual void                        cancelScheduledTask(TimerId id) = 0;
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,46 @@
+#include "investmentIndex.h"
+#include "utils/epochReclaimer.h"
+
+namespace stockbot {
+
+InvestmentIndex::InvestmentIndex()
+    : m_slots(std::make_unique<std::atomic<const TickerInvestments*>[]>(SymbolTable::MAX_SYMBOLS))
+{
+    for (size_t i = 0; i < SymbolTable::MAX_SYMBOLS; ++i) {
+        m_slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+InvestmentIndex::~InvestmentIndex()
+{
+    // no readers left, the published versions go directly
+    for (size_t i = 0; i < SymbolTable::MAX_SYMBOLS; ++i) {
+        delete m_slots[i].load(std::memory_order_relaxed);
+    }
+    EpochReclaimer::instance().reclaim();
+}
+
+void InvestmentIndex::update(SymbolId symbol, const Mutation& mutate)
+{
+    if (symbol >= SymbolTable::MAX_SYMBOLS) {
+        return;
+    }
+
+    std::lock_guard lock(m_writeMutex);
+
+    const TickerInvestments* current = m_slots[symbol].load(std::memory_order_relaxed);
+    std::vector<AutoInvestment> investments = current ? current->investments : std::vector<AutoInvestment>{};
+    mutate(investments);
+
+    const TickerInvestments* next = nullptr;
+    if (!investments.empty()) {
+        RuleSet rules(investments);
+        next = new TickerInvestments{ std::move(investments), std::move(rules) };
+    }
+
+    // seq_cst, ordered before the epoch bump in retire()
+    m_slots[symbol].store(next, std::memory_order_seq_cst);
+    EpochReclaimer::instance().retire(current);
+}
+
+} // namespace stockbot
@@ -0,0 +1,64 @@
+#ifndef __INVESTMENT_INDEX_H__
+#define __INVESTMENT_INDEX_H__
+
+#include "autoInvestment.h"
+#include "rule/ruleSet.h"
+#include "utils/symbolTable.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stockbot {
+
+// the investments on one ticker, immutable once published
+struct TickerInvestments {
+    std::vector<AutoInvestment>     investments;
+    RuleSet                         rules;          // compiled investments, same order
+};
+
+// Active investments by SymbolId, read without locks.
+//
+// Every ticker has its own immutable version published through an atomic pointer. Writers copy
+// the version, change the copy and swap it in; the old one is retired to the EpochReclaimer and
+// destroyed once no reader can hold it. Readers load inside an EpochGuard.
+class InvestmentIndex
+{
+public:
+    using Mutation = std::function<void(std::vector<AutoInvestment>& investments)>;
+
+                                    InvestmentIndex();
+                                    ~InvestmentIndex();
+
+    // -- readers, the result is valid until the EpochGuard it was loaded in ends
+    const TickerInvestments*        find(SymbolId symbol) const
+                                    {
+                                        return symbol < SymbolTable::MAX_SYMBOLS ? m_slots[symbol].load(std::memory_order_acquire) : nullptr;
+                                    }
+
+    // fn(SymbolId, const TickerInvestments&) for every ticker with investments
+    template <typename Fn>
+    void                            forEach(Fn&& fn) const
+                                    {
+                                        for (SymbolId symbol = 0; symbol < SymbolTable::MAX_SYMBOLS; ++symbol) {
+                                            if (const TickerInvestments* ticker = find(symbol)) {
+                                                fn(symbol, *ticker);
+                                            }
+                                        }
+                                    }
+
+    // -- writers, serialized with each other. Builds and publishes a new version of the ticker from
+    // its investments after mutate. The indices of existing investments must not move, the rule
+    // decisions refer to them.
+    void                            update(SymbolId symbol, const Mutation& mutate);
+
+private:
+    std::unique_ptr<std::atomic<const TickerInvestments*>[]>
+                                    m_slots;        // indexed by SymbolId
+    std::mutex                      m_writeMutex;
+};
+
+} // namespace stockbot
+
+#endif
@@ -1,12 +1,16 @@
 #include "investmentManager.h"
 #include "buffer/equityDataBuffer.h"
 #include "buffer/streamDataBuffer.h"
-#include "app.h"
+#include "rule/ruleSet.h"
+#include "rule/tradingWindow.h"
+#include "utils/epochReclaimer.h"
+#include "utils/latencyMetrics.h"
 #include "utils/logger.h"
+#include "utils/timing.h"
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
-#include <shared_mutex>
+#include <iterator>
 
 #ifdef TARGET_LOGGER
 #undef TARGET_LOGGER
@@ -19,18 +23,42 @@ static const std::filesystem::path DATA_DIR("./stockbot_data");
 static const std::filesystem::path FILENAME("investment_manager.json");
 static const std::filesystem::path CACHE_PATH = DATA_DIR / FILENAME;
 
-InvestmentManager::InvestmentManager(std::shared_ptr<App> app, std::shared_ptr<spdlog::logger> logger)
-    : m_app(app)
+// enqueue time of the frame the decoder on this thread is working on
+static thread_local int64_t t_frameReceivedNs = 0;
+
+thread_local std::vector<InvestmentManager::StreamUpdate> InvestmentManager::t_decodedUpdates;
+
+InvestmentManager::InvestmentManager(const Spec& spec, std::shared_ptr<InvestmentHost> host, std::shared_ptr<spdlog::logger> logger)
+    : m_spec(spec)
+    , m_streamDataQueue(STREAM_QUEUE_CAPACITY)
+    , m_host(host)
     , m_logger(logger)
 {
-    load();
+    if (m_spec.streamWorkerCount < 1) {
+        LOG_WARN("Invalid stream worker count {}, using 1.", m_spec.streamWorkerCount);
+        m_spec.streamWorkerCount = 1;
+    }
+
+    if (m_spec.conflateUpdates && !m_spec.partitionedIngest) {
+        LOG_WARN("Update conflation requires partitioned ingest, disabled.");
+        m_spec.conflateUpdates = false;
+    }
+
+    if (m_spec.persistInvestments) {
+        load();
+    }
     LOG_INFO("InvestmentManager initialized.");
 }
 
 InvestmentManager::~InvestmentManager()
 {
     stop();
-    save();
+    if (m_spec.persistInvestments) {
+        save();
+    }
+
+    // release buffer
+    m_streamDataBuffer.reset();
 }
 
 void InvestmentManager::addPendingInvestment(AutoInvestment&& investment)
@@ -43,7 +71,7 @@ void InvestmentManager::linkAndRegisterAutoInvestment(const std::string& investm
     if (m_pendingRegistration.contains(investmentId)) {
         auto& investment = m_pendingRegistration[investmentId];
         investment.accounts = accounts;
-        m_registrationQueue.push(investment);
+        m_registrationQueue.push(std::move(investment));
         // remove pending item
         m_pendingRegistration.erase(investmentId);
 
@@ -53,9 +81,48 @@ void InvestmentManager::linkAndRegisterAutoInvestment(const std::string& investm
     }
 }
 
-void InvestmentManager::enqueueStreamData(const std::string& data)
+void InvestmentManager::enqueueStreamData(std::string data)
 {
-    m_streamDataQueue.push(data);
+    enqueueStreamData(std::move(data), monotonicNowNs());
+}
+
+void InvestmentManager::enqueueStreamData(std::string data, int64_t receivedNs)
+{
+    m_framesReceived.fetch_add(1, std::memory_order_relaxed);
+    uint64_t seq = m_nextFrameSeq.fetch_add(1, std::memory_order_relaxed);
+    if (!m_streamDataQueue.push(StreamFrame{ std::move(data), seq, receivedNs, monotonicNowNs() }) && m_decodedFrames) {
+        // stopped, still fill the slot or the routing waits for this frame forever
+        std::vector<StreamUpdate> none;
+        publishDecodedFrame(seq, none);
+    }
+    // includes the time blocked on a full queue
+    LatencyMetrics::instance().record(LatencyStage::StreamHandler, monotonicNowNs() - receivedNs);
+}
+
+InvestmentManager::StreamIngestStats InvestmentManager::getStreamIngestStats() const
+{
+    StreamIngestStats stats;
+    stats.framesReceived = m_framesReceived.load(std::memory_order_relaxed);
+    stats.parseErrors = m_parseErrors.load(std::memory_order_relaxed);
+    stats.updatesRouted = m_updatesRouted.load(std::memory_order_relaxed);
+    stats.updatesApplied = m_updatesApplied.load(std::memory_order_relaxed);
+    stats.tasksDeduplicated = m_tasksDeduplicated.load(std::memory_order_relaxed);
+    stats.streamQueueDepth = m_streamDataQueue.size();
+    for (const auto& partition : m_partitions) {
+        stats.updatesConflated += partition->conflatingQueue.conflatedCount();
+        stats.updatesApplied += partition->updatesApplied.load(std::memory_order_relaxed);
+        stats.partitionQueueDepth += partition->queue.size() + partition->conflatingQueue.size();
+    }
+    return stats;
+}
+
+InvestmentManager::RegistrationStats InvestmentManager::getRegistrationStats() const
+{
+    RegistrationStats stats;
+    stats.pendingRegistrations = m_registrationQueue.size();
+    stats.activeInvestments = m_activeInvestmentCount.load(std::memory_order_relaxed);
+    stats.subscribedSymbols = m_subscribedSymbolCount.load(std::memory_order_relaxed);
+    return stats;
 }
 
 void InvestmentManager::run()
@@ -68,36 +135,95 @@ void InvestmentManager::run()
 
     LOG_INFO("Registration worker started.");
 
-    // 2 workers for now
-    m_streamDataWorkerPool.resize(2);
-    for (auto& worker : m_streamDataWorkerPool) {
-        worker = std::thread(std::bind(&InvestmentManager::processStreamData, this));
+    if (m_spec.persistInvestments) {
+        scheduleSave();
     }
 
-    LOG_INFO("Stream data workers started.");
+    m_streamDataWorkerPool.resize(m_spec.streamWorkerCount);
+    if (m_spec.partitionedIngest) {
+        // each worker drains its own partition, the decoders route to them. All the
+        // partitions exist before any worker reads m_partitions.
+        m_decodedFrames = std::make_unique<DecodedFrame[]>(REORDER_WINDOW);
+        for (size_t partition = 0; partition < m_streamDataWorkerPool.size(); ++partition) {
+            m_partitions.push_back(std::make_unique<Partition>());
+        }
+        for (size_t partition = 0; partition < m_streamDataWorkerPool.size(); ++partition) {
+            m_streamDataWorkerPool[partition] = std::thread(std::bind(&InvestmentManager::processPartition, this, partition));
+        }
+        m_streamDecoderPool.resize(m_spec.streamWorkerCount);
+        for (auto& decoder : m_streamDecoderPool) {
+            decoder = std::thread(std::bind(&InvestmentManager::processStreamData, this));
+        }
+    } else {
+        for (auto& worker : m_streamDataWorkerPool) {
+            worker = std::thread(std::bind(&InvestmentManager::processStreamData, this));
+        }
+    }
+
+    LOG_INFO(
+        "{} stream data workers and {} decoders started ({} ingest{}).",
+        m_streamDataWorkerPool.size(),
+        m_streamDecoderPool.size(),
+        m_spec.partitionedIngest ? "partitioned" : "shared",
+        m_spec.conflateUpdates ? ", conflating" : ""
+    );
 }
 
 void InvestmentManager::stop()
 {
+    if (m_stopped) {
+        return;
+    }
+    m_stopped = true;
+
+    // nothing fires or reschedules from here on
+    {
+        std::lock_guard lock(m_mtTriggerTimers);
+        m_triggerTimersStopped = true;
+        for (const auto& [investmentId, timer] : m_triggerTimers) {
+            m_host->cancelScheduledTask(timer);
+        }
+        m_triggerTimers.clear();
+        if (m_saveTimer != 0) {
+            m_host->cancelScheduledTask(m_saveTimer);
+        }
+    }
+
     // stop workers
+    // pending registrations are cached by save()
     LOG_INFO("Shutting down registration queue and stopping registration worker...");
     m_registrationQueue.shutdown();
 
-    LOG_INFO("Shutting down stream data queue and stopping stream data workers...");
-    m_streamDataQueue.shutdown();
+    // frames already received are still processed
+    LOG_INFO("Draining stream data queue and stopping stream data workers...");
+    m_streamDataQueue.shutdown(ShutdownMode::Drain);
 
     if (m_registrationWorker.joinable()) {
         m_registrationWorker.join();
     }
 
+    // the decoders feed the partitions, stop them first
+    for (auto& decoder : m_streamDecoderPool) {
+        if (decoder.joinable()) {
+            decoder.join();
+        }
+    }
+
+    for (auto& partition : m_partitions) {
+        partition->queue.shutdown(ShutdownMode::Drain);
+        partition->conflatingQueue.shutdown(ShutdownMode::Drain);
+    }
+
+    if (m_spec.conflateUpdates) {
+        StreamIngestStats stats = getStreamIngestStats();
+        LOG_INFO("{} of {} stream updates conflated.", stats.updatesConflated, stats.updatesRouted);
+    }
+
     for (auto& worker : m_streamDataWorkerPool) {
         if (worker.joinable()) {
             worker.join();
         }
     }
-
-    // release buffer
-    m_streamDataBuffer.reset();
 }
 
 void InvestmentManager::save()
@@ -114,11 +240,10 @@ void InvestmentManager::save()
         // collect all
         std::vector<AutoInvestment> collection;
         {
-            // read lock
-            std::shared_lock lock(m_mtInvestment);
-            for (const auto& [_, investment] : m_activeInvestments) {
-                collection.push_back(investment);
-            }
+            EpochGuard guard;
+            m_activeInvestments.forEach([&collection](SymbolId, const TickerInvestments& ticker) {
+                collection.insert(collection.end(), ticker.investments.begin(), ticker.investments.end());
+            });
         }
 
         // remaining ones in the queue
@@ -162,132 +287,360 @@ void InvestmentManager::load()
 
 void InvestmentManager::processRegistrations()
 {
-    AutoInvestment investment;
-    while (m_registrationQueue.pop(investment)) {
-        // add to active
-        {
-            // write lock
-            std::unique_lock lock(m_mtInvestment);
-            m_activeInvestments.emplace(investment.ticker, investment);
+    // Whatever is queued is registered together: every index update copies the version of the
+    // symbol and recompiles its rules, so a symbol gets one update per batch, not per investment.
+    std::vector<AutoInvestment> batch;
+    std::vector<std::pair<SymbolId, size_t>> bySymbol;     // symbol, index in batch
+    std::vector<std::string> tickers;
+    while (m_registrationQueue.popBulk(std::back_inserter(batch), REGISTRATION_BATCH_SIZE) > 0) {
+        bySymbol.clear();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            // the ticker is interned once here, the stream pipeline only deals with the id
+            SymbolId symbol = SymbolTable::instance().intern(batch[i].ticker);
+            if (symbol == INVALID_SYMBOL) {
+                LOG_ERROR("Symbol table full, unable to register {}.", batch[i].ticker);
+                continue;
+            }
+            bySymbol.emplace_back(symbol, i);
+        }
+        // stable, the investments of a symbol keep their registration order
+        std::stable_sort(bySymbol.begin(), bySymbol.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        tickers.clear();
+        for (size_t begin = 0, end; begin < bySymbol.size(); begin = end) {
+            SymbolId symbol = bySymbol[begin].first;
+            for (end = begin + 1; end < bySymbol.size() && bySymbol[end].first == symbol; ++end) {}
+
+            // add to active, appending keeps the rule indices of the existing investments
+            m_activeInvestments.update(symbol, [&](std::vector<AutoInvestment>& investments) {
+                if (investments.empty()) {
+                    m_subscribedSymbolCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                for (size_t i = begin; i < end; ++i) {
+                    investments.push_back(batch[bySymbol[i].second]);
+                }
+            });
+            m_activeInvestmentCount.fetch_add(end - begin, std::memory_order_relaxed);
+            // have the buffer ready before the first tick arrives
+            m_streamDataBuffer->registerSymbol(symbol);
+
+            tickers.push_back(batch[bySymbol[begin].second].ticker);
         }
+
         // simply subscribing the tickers with the streamer client
-        m_app->subscribeTickersToStream({investment.ticker});
+        if (!tickers.empty()) {
+            m_host->subscribeTickersToStream(tickers);
+        }
+
+        for (const auto& [symbol, index] : bySymbol) {
+            const AutoInvestment& investment = batch[index];
+            // a window missed while down (not committed, see commitTrigger) is evaluated right away
+            scheduleTrigger(symbol, investment.id, investment.frequency, nextTrigger(investment, clock::now()));
 
-        LOG_DEBUG("{} registered.", investment.ticker);
+            LOG_DEBUG("{} registered.", investment.ticker);
+        }
+        batch.clear();
     }
 }
 
 void InvestmentManager::processStreamData()
 {
-    std::string data;
-    while (m_streamDataQueue.pop(data)) {
-        try {
-            json jsonData = json::parse(data);
-            // LOG_INFO("\n{}", jsonData.dump(4));
-
-            // only care about "data" field
-            if (jsonData.contains("data")) {
-                // "data" filed contains a vector of data grouped by the service type
-                for (const json& serviceData : jsonData["data"]) {
-                    // process contents of
-                    // LEVELONE_EQUITIES service
-                    // SUBS command
-                    // for now, could expand in the future
-                    if (serviceData["service"] == "LEVELONE_EQUITIES" &&
-                        serviceData["command"] == "SUBS"
-                    ) {
-                        // "content" field contains a vector of data grouped by the "key"
-                        // which is the ticker for level one equities
-                        std::string ticker("");
-                        std::unordered_map<schwabcpp::StreamerField::LevelOneEquity, double> fields;
-                        for (const json& contentData : serviceData["content"]) {
-                            // iterate
-                            for (auto it = contentData.begin(); it != contentData.end(); ++it) {
-                                const auto& key = it.key();
-                                const auto& val = it.value();
-                                if (key == "delayed" ||
-                                    key == "assetMainType" ||
-                                    key == "assetSubType" ||
-                                    key == "cusip"
-                                ) {
-                                    // the very first response will contain these in addition to the subscribed fields
-                                    // ignoring them for now
-                                    continue;
-                                } else if (key == "key") {
-                                    // the ticker
-                                    ticker = val;
-                                } else {
-                                    // subscribed fields
-                                    fields.emplace(schwabcpp::StreamerField::toLevelOneEquityField(key), val.get<double>());
-                                }
-                            }
-                            // add the data into stream buffer
-                            // create and register the task
-                            std::weak_ptr<EquityDataBuffer> equityBufferRef = m_streamDataBuffer->addLevelOneEquityData(ticker, fields);
-                            createAndRegisterTask(ticker, equityBufferRef);
-                        }
-                    } else {
-                        LOG_WARN(
-                            "Unsupported service type: {} (command: {})",
-                            serviceData["service"].get<std::string>(),
-                            serviceData["command"].get<std::string>()
-                        );
-                    }
-                }
-            } else {
+    // one decoder per worker
+    StreamFrameDecoder decoder;
+
+    std::vector<StreamFrame> frames;
+    frames.reserve(STREAM_BATCH_SIZE);
+    while (m_streamDataQueue.popBulk(std::back_inserter(frames), STREAM_BATCH_SIZE)) {
+        for (const StreamFrame& frame : frames) {
+            processStreamFrame(decoder, frame);
+        }
+        frames.clear();
+    }
+}
+
+void InvestmentManager::processStreamFrame(StreamFrameDecoder& decoder, const StreamFrame& frame)
+{
+    LatencyMetrics& metrics = LatencyMetrics::instance();
+    int64_t startNs = monotonicNowNs();
+    metrics.record(LatencyStage::StreamQueueWait, startNs - frame.enqueuedNs);
+
+    t_frameReceivedNs = frame.receivedNs;
+    try {
+        StreamFrameDecoder::Status status = decoder.decode(frame.data, *this);
+        // with shared ingest the updates are applied inside decode(), otherwise they are collected
+        metrics.record(LatencyStage::Decode, monotonicNowNs() - startNs);
+
+        switch (status) {
+            case StreamFrameDecoder::Status::Ok: break;
+            case StreamFrameDecoder::Status::NoData:
+            {
                 LOG_DEBUG("Ignoring empty data...");
+                break;
+            }
+            case StreamFrameDecoder::Status::Malformed:
+            {
+                m_parseErrors.fetch_add(1, std::memory_order_relaxed);
+                LOG_ERROR("Unable to process stream data: malformed frame at offset {}.", decoder.errorOffset());
+                break;
             }
-        } catch (const json::exception& e) {
-            LOG_ERROR("Unable to process stream data: {}.", e.what());
-        } catch (...) {
-            LOG_ERROR("Unknown error ocurred when processing stream data.");
         }
+    } catch (...) {
+        LOG_ERROR("Unknown error ocurred when processing stream data.");
+    }
+
+    // every frame is published, even a malformed one, the routing waits for each seq in turn
+    if (m_spec.partitionedIngest) {
+        publishDecodedFrame(frame.seq, t_decodedUpdates);
     }
 }
 
-void InvestmentManager::createAndRegisterTask(const std::string& ticker, std::weak_ptr<EquityDataBuffer> equityBufferRef)
+void InvestmentManager::publishDecodedFrame(uint64_t seq, std::vector<StreamUpdate>& updates)
 {
-    std::unique_lock lock(m_mtTaskRecord);
-    if (!m_taskRecord.contains(ticker)) {
-        m_taskRecord.insert(ticker);
-        lock.unlock();
-
-        auto task = [this, ticker, equityBufferRef] {
-
-            // temporarily obtain ownership of the buffer
-            if (std::shared_ptr<EquityDataBuffer> buffer = equityBufferRef.lock()) {
-
-                // placeholders for the interested buffer data
-                double lastPrice;
-                double lod;
-                double hod;
-                double netPercentChange;
-
-                // thread safe access
-                {
-                    auto lock = buffer->lockForAccess();
-
-                    lastPrice = buffer->getLastPrice();
-                    lod = buffer->getLOD();
-                    hod = buffer->getHOD();
-                    netPercentChange = buffer->getNetPercentChange();
-                }
+    // the slot is free once the frame a window earlier has been routed
+    m_reorderSpace.wait([this, seq] { return seq < m_nextRoutedSeq.load(std::memory_order_acquire) + REORDER_WINDOW; });
 
-                // TODO: analyze and signal
-                LOG_INFO("{}: last price {:.2f}, lod {:.2f}, hod {:.2f}, net change {:.2f}%", ticker, lastPrice, lod, hod, netPercentChange);
-            }
+    DecodedFrame& slot = m_decodedFrames[seq % REORDER_WINDOW];
+    // the router leaves the slot's vector empty, the capacities go round
+    slot.updates.swap(updates);
+    // seq_cst, pairs with the check in routeDecodedFrames() once m_routing is released
+    slot.ready.store(true);
 
-            // remove from record
-            {
-                std::lock_guard lock(m_mtTaskRecord);
-                m_taskRecord.erase(ticker);
+    routeDecodedFrames();
+}
+
+void InvestmentManager::routeDecodedFrames()
+{
+    // one router at a time, the others leave their frames to it
+    while (!m_routing.exchange(true)) {
+        uint64_t seq = m_nextRoutedSeq.load(std::memory_order_relaxed);
+        for (DecodedFrame* slot = &m_decodedFrames[seq % REORDER_WINDOW]; slot->ready.load(std::memory_order_acquire); slot = &m_decodedFrames[seq % REORDER_WINDOW]) {
+            int64_t routedNs = monotonicNowNs();
+            for (StreamUpdate& update : slot->updates) {
+                // a symbol always lands on the same worker, its updates stay in order
+                Partition& target = *m_partitions[update.symbol % m_partitions.size()];
+                update.routedNs = routedNs;
+                if (m_spec.conflateUpdates) {
+                    target.conflatingQueue.push(update.symbol, update);
+                } else {
+                    target.queue.push(std::move(update));
+                }
             }
-        };
+            m_updatesRouted.fetch_add(slot->updates.size(), std::memory_order_relaxed);
+            slot->updates.clear();
+            slot->ready.store(false, std::memory_order_relaxed);
+            m_nextRoutedSeq.store(++seq, std::memory_order_release);
+        }
+        m_routing.store(false);
+        m_reorderSpace.notifyAll();
+
+        // a frame published while we were routing found m_routing taken, it is ours
+        if (!m_decodedFrames[seq % REORDER_WINDOW].ready.load()) {
+            break;
+        }
+    }
+}
+
+void InvestmentManager::processPartition(size_t partition)
+{
+    Partition& target = *m_partitions[partition];
+
+    LatencyMetrics& metrics = LatencyMetrics::instance();
+
+    // conflated updates keep the routing time of the oldest one merged in
+    auto popBulk = [this, &target](std::vector<StreamUpdate>& updates) {
+        return m_spec.conflateUpdates ? target.conflatingQueue.popBulk(std::back_inserter(updates), STREAM_BATCH_SIZE)
+                                      : target.queue.popBulk(std::back_inserter(updates), STREAM_BATCH_SIZE);
+    };
+
+    std::vector<StreamUpdate> updates;
+    updates.reserve(STREAM_BATCH_SIZE);
+    while (popBulk(updates) > 0) {
+        int64_t poppedNs = monotonicNowNs();
+        for (const StreamUpdate& update : updates) {
+            metrics.record(LatencyStage::PartitionQueueWait, poppedNs - update.routedNs);
+            applyLevelOneEquity(update.symbol, update.fields, update.receivedNs);
+        }
+        // single writer, no read-modify-write needed
+        target.updatesApplied.store(target.updatesApplied.load(std::memory_order_relaxed) + updates.size(), std::memory_order_relaxed);
+        updates.clear();
+    }
+}
+
+void InvestmentManager::onLevelOneEquity(std::string_view ticker, const LevelOneFieldSet& fields)
+{
+    // only tickers interned at registration are subscribed
+    SymbolId symbol = SymbolTable::instance().find(ticker);
+    if (symbol == INVALID_SYMBOL) {
+        LOG_DEBUG("Ignoring data of unregistered ticker {}.", ticker);
+        return;
+    }
 
-        m_app->registerTask(task);
+    if (m_spec.partitionedIngest) {
+        // routed once the whole frame is decoded, see publishDecodedFrame
+        t_decodedUpdates.push_back({ symbol, fields, t_frameReceivedNs });
     } else {
-        LOG_DEBUG("Task already exists for {}", ticker);
+        applyLevelOneEquity(symbol, fields, t_frameReceivedNs);
+        m_updatesApplied.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
+void InvestmentManager::applyLevelOneEquity(SymbolId symbol, const LevelOneFieldSet& fields, int64_t receivedNs)
+{
+    // add the data into stream buffer
+    // create and register the task
+    int64_t startNs = monotonicNowNs();
+    const std::shared_ptr<EquityDataBuffer>& equityBuffer = m_streamDataBuffer->addLevelOneEquityData(symbol, fields);
+    LatencyMetrics::instance().record(LatencyStage::BufferUpdate, monotonicNowNs() - startNs);
+
+    createAndRegisterTask(symbol, equityBuffer, receivedNs);
+
+    if (m_spec.onUpdateApplied) {
+        m_spec.onUpdateApplied(symbol, receivedNs);
+    }
+}
+
+void InvestmentManager::onUnsupportedService(std::string_view service, std::string_view command)
+{
+    LOG_WARN("Unsupported service type: {} (command: {})", service, command);
+}
+
+void InvestmentManager::createAndRegisterTask(SymbolId symbol, const std::shared_ptr<EquityDataBuffer>& equityBuffer, int64_t receivedNs)
+{
+    // a task already pending reads this update too
+    if (!equityBuffer->tryScheduleTask()) {
+        m_tasksDeduplicated.fetch_add(1, std::memory_order_relaxed);
+        LOG_DEBUG("Task already exists for {}", SymbolTable::instance().name(symbol));
+        return;
+    }
+
+    // receivedNs is the tick that scheduled the task, later ticks only update the buffer
+    auto task = [this, symbol, equityBufferRef = std::weak_ptr<EquityDataBuffer>(equityBuffer), receivedNs] {
+        LatencyMetrics::instance().record(LatencyStage::TickToTask, monotonicNowNs() - receivedNs);
+
+        // temporarily obtain ownership of the buffer
+        if (std::shared_ptr<EquityDataBuffer> buffer = equityBufferRef.lock()) {
+            // again for as long as updates keep coming in while it runs, the last one is never missed
+            bool decided = false;
+            do {
+                // consistent snapshot of the buffer data, doesn't block the stream workers
+                EquityQuote quote = buffer->snapshot();
+
+                evaluateRules(symbol, quote);
+                if (!decided) {
+                    LatencyMetrics::instance().record(LatencyStage::TickToDecision, monotonicNowNs() - receivedNs);
+                    decided = true;
+                }
+                LOG_INFO("{}: last price {:.2f}, lod {:.2f}, hod {:.2f}, net change {:.2f}%", SymbolTable::instance().name(symbol), quote.lastPrice, quote.lod, quote.hod, quote.netPercentChange);
+            } while (buffer->finishTask());
+        }
+    };
+
+    m_host->registerTask(std::move(task), { .priority = TaskPriority::Normal });
+}
+
+void InvestmentManager::scheduleTrigger(SymbolId symbol, const std::string& investmentId, AutoInvestment::Frequency frequency, clock::time_point due)
+{
+    if (due == clock::time_point::max()) {
+        return;
+    }
+
+    // The timers run on the monotonic clock. Should the wall clock drift until then, a timer
+    // firing ahead of the opening finds the window not started and reschedules for it.
+    int64_t dueNs = monotonicNowNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(due - clock::now()).count();
+
+    auto task = [this, symbol, investmentId = investmentId, frequency] {
+        clock::time_point now = clock::now();
+
+        // Recomputed from the investment as it is now: a window the order path already committed,
+        // or that signalled on a tick before the timer, is skipped. So is a timer firing ahead of
+        // the opening, it only reschedules.
+        bool registered = false;
+        bool due = false;
+        {
+            EpochGuard guard;
+            if (const TickerInvestments* ticker = m_activeInvestments.find(symbol)) {
+                auto investment = std::find_if(ticker->investments.begin(), ticker->investments.end(),
+                                               [&investmentId](const AutoInvestment& investment) { return investment.id == investmentId; });
+                if (investment != ticker->investments.end()) {
+                    registered = true;
+                    due = nextTrigger(*investment, now) <= now;
+                }
+            }
+        }
+        if (!registered) {
+            return;
+        }
+
+        // goes through the per tick task, the tasks of a symbol never overlap
+        if (due) {
+            createAndRegisterTask(symbol, m_streamDataBuffer->registerSymbol(symbol), monotonicNowNs());
+        }
+        scheduleTrigger(symbol, investmentId, frequency, nextWindowOpen(frequency, now));
+    };
+
+    std::lock_guard lock(m_mtTriggerTimers);
+    if (!m_triggerTimersStopped) {
+        m_triggerTimers[investmentId] = m_host->scheduleTask(dueNs, std::move(task), { .priority = TaskPriority::Critical });
+    }
+}
+
+void InvestmentManager::scheduleSave()
+{
+    // housekeeping, no deadline: an expired save would never schedule the next one
+    auto task = [this] {
+        save();
+        scheduleSave();
+    };
+
+    int64_t dueNs = monotonicNowNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(SAVE_INTERVAL).count();
+
+    std::lock_guard lock(m_mtTriggerTimers);
+    if (!m_triggerTimersStopped) {
+        m_saveTimer = m_host->scheduleTask(dueNs, std::move(task), { .priority = TaskPriority::Background });
+    }
+}
+
+void InvestmentManager::evaluateRules(SymbolId symbol, const EquityQuote& quote)
+{
+    RuleInputs inputs{
+        .change = quote.netPercentChange / 100.0,
+        .rebound = quote.lod > 0.0 ? (quote.lastPrice - quote.lod) / quote.lod : std::numeric_limits<double>::quiet_NaN(),
+        .windowStarts = RuleSet::windowStarts(clock::now()),
+    };
+
+    // reused by every task on this thread
+    thread_local std::vector<RuleDecision> decisions;
+    decisions.clear();
+    {
+        EpochGuard guard;
+        const TickerInvestments* ticker = m_activeInvestments.find(symbol);
+        if (!ticker || ticker->rules.evaluate(inputs, decisions) == 0) {
+            return;
+        }
+    }
+
+    // Rare, at most once per rule and window. Only the in memory signal time is stamped so the
+    // window signals once, lastTriggerTime waits for commitTrigger. The tasks of a symbol never
+    // overlap, nothing else fires its rules before the new version is published.
+    clock::rep now = clock::now().time_since_epoch().count();
+    m_activeInvestments.update(symbol, [&](std::vector<AutoInvestment>& investments) {
+        for (const RuleDecision& decision : decisions) {
+            const AutoInvestment& investment = investments[decision.rule];
+            investments[decision.rule].signalledTime = now;
+            LOG_INFO("{} ({}): {} {} shares at {:.2f}, day change {:.2f}%", investment.id, investment.ticker, toString(decision.signal), decision.shares, quote.lastPrice, quote.netPercentChange);
+        }
+    });
+}
+
+void InvestmentManager::commitTrigger(SymbolId symbol, const std::string& investmentId, clock::rep triggerTime)
+{
+    m_activeInvestments.update(symbol, [&](std::vector<AutoInvestment>& investments) {
+        for (AutoInvestment& investment : investments) {
+            if (investment.id == investmentId) {
+                investment.lastTriggerTime = std::max(investment.lastTriggerTime, triggerTime);
+            }
+        }
+    });
+}
+
 }
@@ -2,24 +2,113 @@
 #define __INVESTMENT_MANAGER_H__
 
 #include "autoInvestment.h"
+#include "investmentHost.h"
+#include "investmentIndex.h"
 #include "spdlog/logger.h"
+#include "stream/streamFrameDecoder.h"
 #include "utils/concurrentQueue.h"
-#include <shared_mutex>
+#include "utils/conflatingQueue.h"
+#include "utils/parker.h"
+#include "utils/ringQueue.h"
+#include "utils/symbolTable.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace stockbot {
 
-class App;
 class StreamDataBuffer;
 class EquityDataBuffer;
+struct EquityQuote;
 
-class InvestmentManager
+class InvestmentManager : private StreamFrameDecoder::Handler
 {
+    // a raw frame, when it was received and when it was enqueued
+    struct StreamFrame {
+        std::string                     data;
+        uint64_t                        seq = 0;                // enqueue order, partitioned ingest routes in this order
+        int64_t                         receivedNs = 0;         // monotonicNowNs()
+        int64_t                         enqueuedNs = 0;
+    };
+
+    // one decoded content entry on its way to a partition worker
+    struct StreamUpdate {
+        SymbolId                        symbol = INVALID_SYMBOL;
+        LevelOneFieldSet                fields;
+        int64_t                         receivedNs = 0;
+        int64_t                         routedNs = 0;           // handed to the partition queue
+
+        // conflation keeps the timestamps of the oldest pending update
+        void                            merge(const StreamUpdate& other) { fields.merge(other.fields); }
+    };
+
+    // raw frames waiting for a decoder, producers block when full
+    static constexpr size_t             STREAM_QUEUE_CAPACITY = 1 << 16;
+    // max items a worker takes off its queue at once
+    static constexpr size_t             STREAM_BATCH_SIZE = 64;
+    static constexpr size_t             PARTITION_QUEUE_CAPACITY = 1 << 12;
+    // max frames decoded ahead of the oldest one not routed yet
+    static constexpr size_t             REORDER_WINDOW = 1 << 10;
+    // max investments registered together, see processRegistrations
+    static constexpr size_t             REGISTRATION_BATCH_SIZE = 1024;
+    // the investment cache is saved this often while running, a crash loses less
+    static constexpr std::chrono::minutes
+                                        SAVE_INTERVAL{ 5 };
+
+    // updates of the frame the decoder on this thread is working on, partitioned ingest
+    static thread_local std::vector<StreamUpdate>
+                                        t_decodedUpdates;
+
 public:
+    struct Spec {
+        int                             streamWorkerCount = 2;
+        // streamWorkerCount decoders share the raw frame queue and route the decoded updates in
+        // enqueue order, every ticker to the same partition worker, so the updates of a symbol
+        // are applied in order. Otherwise the workers decode and apply as they go and two frames
+        // of the same ticker can be applied out of order.
+        bool                            partitionedIngest = true;
+        // Only with partitioned ingest. The decoders keep up with the frames and only the latest
+        // pending update per ticker (fields merged, keyed by SymbolId) waits for the partition
+        // worker. The backlog is then bounded by the subscribed symbols instead of piling up
+        // as stale frames in the raw queue.
+        bool                            conflateUpdates = false;
+        // Load the investments cached by the last run at construction and cache them again at
+        // destruction, and every SAVE_INTERVAL in between on the background lane. Off for
+        // offline runs that must not touch the live cache.
+        bool                            persistInvestments = true;
+        // Called on the stream workers after each update is applied, with the receive time of its
+        // frame (monotonicNowNs(), see enqueueStreamData). Meant for benchmarks and diagnostics, it runs on the ingest path.
+        std::function<void(SymbolId symbol, int64_t receivedNs)>
+                                        onUpdateApplied = nullptr;
+    };
+
+    struct StreamIngestStats {
+        // -- counters since construction
+        uint64_t                        framesReceived = 0;
+        uint64_t                        parseErrors = 0;        // malformed frames
+        uint64_t                        updatesRouted = 0;      // content entries handed to the partitions
+        uint64_t                        updatesConflated = 0;   // merged into a pending update instead of queued
+        uint64_t                        updatesApplied = 0;     // written to the stream data buffer
+        uint64_t                        tasksDeduplicated = 0;  // updates of a symbol that already had a task scheduled
+
+        // -- current, approximate
+        size_t                          streamQueueDepth = 0;   // raw frames waiting for a decoder
+        size_t                          partitionQueueDepth = 0; // updates waiting in all the partitions
+    };
+
+    struct RegistrationStats {
+        size_t                          pendingRegistrations = 0; // queued for the registration worker
+        size_t                          activeInvestments = 0;
+        size_t                          subscribedSymbols = 0;  // symbols with at least one active investment
+    };
+
                                         InvestmentManager(
-                                            std::shared_ptr<App> app,
+                                            const Spec& spec,
+                                            std::shared_ptr<InvestmentHost> host,
                                             std::shared_ptr<spdlog::logger> logger
                                         );
                                         ~InvestmentManager();
@@ -29,43 +118,104 @@ public:
     void                                addPendingInvestment(AutoInvestment&& investment);
     void                                linkAndRegisterAutoInvestment(const std::string& investmentId, const std::vector<std::string>& accounts);
 
-    void                                enqueueStreamData(const std::string& data);
+    // For whatever acts on the signals of the rules (the order path): records that the investment
+    // acted on the window of triggerTime, cached with the investments and what nextTrigger()
+    // recomputes from after a restart. Until then the window signals once per run.
+    void                                commitTrigger(SymbolId symbol, const std::string& investmentId, clock::rep triggerTime);
 
-private:
+    // takes the frame by value, pass an rvalue to avoid the copy
+    void                                enqueueStreamData(std::string data);
+    // receivedNs is the monotonicNowNs() the frame came off the socket, the tick latencies start there
+    void                                enqueueStreamData(std::string data, int64_t receivedNs);
+
+    // safe to call from any thread while running
+    StreamIngestStats                   getStreamIngestStats() const;
+    RegistrationStats                   getRegistrationStats() const;
+
+    // Stops the workers. Frames and updates already queued are still processed, so stop before
+    // the task manager goes away. Called again by the destructor, no-op the second time.
     void                                stop();
 
+private:
     void                                save();
     void                                load();
 
     void                                processRegistrations();
     void                                processStreamData();
+    void                                processStreamFrame(StreamFrameDecoder& decoder, const StreamFrame& frame);
+    void                                processPartition(size_t partition);
+    // partitioned ingest, hands the updates decoded from frame seq over to the routing
+    void                                publishDecodedFrame(uint64_t seq, std::vector<StreamUpdate>& updates);
+    void                                routeDecodedFrames();
+
+    void                                applyLevelOneEquity(SymbolId symbol, const LevelOneFieldSet& fields, int64_t receivedNs);
+
+    // -- StreamFrameDecoder::Handler
+    void                                onLevelOneEquity(std::string_view ticker, const LevelOneFieldSet& fields) override;
+    void                                onUnsupportedService(std::string_view service, std::string_view command) override;
 
-    void                                createAndRegisterTask(const std::string& ticker, std::weak_ptr<EquityDataBuffer> equityBufferRef);
+    void                                createAndRegisterTask(SymbolId symbol, const std::shared_ptr<EquityDataBuffer>& equityBuffer, int64_t receivedNs);
+    // evaluates the rules of the symbol at due, then again at every window opening after it
+    void                                scheduleTrigger(SymbolId symbol, const std::string& investmentId, AutoInvestment::Frequency frequency, clock::time_point due);
+    void                                evaluateRules(SymbolId symbol, const EquityQuote& quote);
+    void                                scheduleSave();
 
 private:
-    // -- active investment container
-    std::unordered_multimap<std::string, AutoInvestment>
-                                        m_activeInvestments;    // thread safe
-    std::shared_mutex                   m_mtInvestment;
+    // -- active investment container, lock free reads
+    InvestmentIndex                     m_activeInvestments;
 
-    // -- task registration management
-    std::unordered_set<std::string>     m_taskRecord;
-    std::mutex                          m_mtTaskRecord;
+    // -- window opening timers, by investment id, and the periodic save
+    std::unordered_map<std::string, TimerId>
+                                        m_triggerTimers;
+    TimerId                             m_saveTimer = 0;
+    bool                                m_triggerTimersStopped = false;
+    std::mutex                          m_mtTriggerTimers;
 
     // -- registration pipeline
     ConcurrentQueue<AutoInvestment>     m_registrationQueue;
     std::thread                         m_registrationWorker;
     std::unordered_map<std::string, AutoInvestment>
                                         m_pendingRegistration;  // not thread safe, should be accessed from only one thread
+    std::atomic<size_t>                 m_activeInvestmentCount = 0;
+    std::atomic<size_t>                 m_subscribedSymbolCount = 0;
 
     // -- stream data processing pipeline
-    ConcurrentQueue<std::string>        m_streamDataQueue;
+    Spec                                m_spec;
+    bool                                m_stopped = false;
+    RingQueue<StreamFrame>              m_streamDataQueue;
     std::vector<std::thread>            m_streamDataWorkerPool;
+    std::atomic<uint64_t>               m_framesReceived = 0;
+    std::atomic<uint64_t>               m_parseErrors = 0;
+    std::atomic<uint64_t>               m_updatesApplied = 0;   // shared ingest, the partitions count their own
+    std::atomic<uint64_t>               m_tasksDeduplicated = 0;
+
+    // -- partitioned ingest. The decoders publish the updates of each frame into the reorder
+    //    window, whoever holds m_routing routes them in frame order. One producer at a time
+    //    for each partition queue.
+    struct DecodedFrame {
+        std::vector<StreamUpdate>       updates;
+        std::atomic<bool>               ready = false;          // published, not routed yet
+    };
+    struct Partition {
+        RingQueue<StreamUpdate, QueueMode::SPSC>
+                                        queue{ PARTITION_QUEUE_CAPACITY };
+        ConflatingQueue<StreamUpdate>   conflatingQueue;        // used instead of queue when conflating
+        std::atomic<uint64_t>           updatesApplied = 0;     // only written by the partition worker
+    };
+    std::vector<std::thread>            m_streamDecoderPool;
+    std::atomic<uint64_t>               m_nextFrameSeq = 0;
+    std::unique_ptr<DecodedFrame[]>     m_decodedFrames;        // REORDER_WINDOW slots, by seq
+    std::atomic<uint64_t>               m_nextRoutedSeq = 0;
+    std::atomic<bool>                   m_routing = false;
+    Parker                              m_reorderSpace;         // decoders waiting for a slot
+    std::vector<std::unique_ptr<Partition>>
+                                        m_partitions;           // indexed by SymbolId % streamWorkerCount
+    std::atomic<uint64_t>               m_updatesRouted = 0;
 
     // -- buffer that holds the processed stream data
     std::unique_ptr<StreamDataBuffer>   m_streamDataBuffer;
 
-    std::shared_ptr<App>                m_app;
+    std::shared_ptr<InvestmentHost>     m_host;
 
     std::shared_ptr<spdlog::logger>     m_logger;
 };
@@ -0,0 +1,60 @@
+#ifndef __JOURNAL_FORMAT_H__
+#define __JOURNAL_FORMAT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace stockbot {
+
+// On disk layout of the raw stream journal.
+//
+//   JournalFileHeader
+//   JournalRecordHeader | frame bytes | zero padding to 8 bytes
+//   JournalRecordHeader | frame bytes | zero padding to 8 bytes
+//   ...
+//
+// Everything is little endian and 8 byte aligned so a mapped file can be walked in place.
+namespace journal {
+
+static constexpr char       MAGIC[8] = { 'S', 'B', 'J', 'R', 'N', 'L', '0', '1' };
+static constexpr uint32_t   VERSION = 1;
+static constexpr size_t     ALIGNMENT = 8;
+
+struct FileHeader {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    reserved;
+};
+
+struct RecordHeader {
+    uint32_t    length;         // frame bytes, excluding header and padding
+    uint32_t    reserved;
+    int64_t     monotonicNs;    // steady clock at receive, only comparable within one process run
+    int64_t     wallNs;         // system clock at receive
+};
+
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(RecordHeader) == 24);
+
+constexpr size_t alignedSize(size_t size)
+{
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+inline bool isValid(const FileHeader& header)
+{
+    return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION;
+}
+
+// total bytes a frame of the given length occupies in the journal
+constexpr size_t recordSize(size_t frameLength)
+{
+    return alignedSize(sizeof(RecordHeader) + frameLength);
+}
+
+} // namespace journal
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,272 @@
+#include "streamJournal.h"
+#include "journalFormat.h"
+#include "utils/logger.h"
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+#ifdef TARGET_LOGGER
+#undef TARGET_LOGGER
+#endif
+#define TARGET_LOGGER m_logger
+
+namespace stockbot {
+
+// the writer wakes up at least this often, also bounds how much a crash can lose
+static constexpr std::chrono::milliseconds FLUSH_INTERVAL(200);
+
+static int64_t nanosecondsSinceEpoch(auto timePoint)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count();
+}
+
+// Size of the intact prefix of an existing journal, a record cut short by a crash is not part
+// of it. False if the file is not a journal.
+static bool validJournalSize(const std::filesystem::path& path, uintmax_t& validSize)
+{
+    uintmax_t fileSize = std::filesystem::file_size(path);
+    if (fileSize < sizeof(journal::FileHeader)) {
+        validSize = 0;
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    journal::FileHeader fileHeader;
+    if (!file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) || !journal::isValid(fileHeader)) {
+        return false;
+    }
+
+    uintmax_t offset = sizeof(journal::FileHeader);
+    journal::RecordHeader header;
+    while (offset + sizeof(header) <= fileSize) {
+        file.seekg(offset);
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            break;
+        }
+
+        uintmax_t next = offset + journal::recordSize(header.length);
+        if (next > fileSize) {
+            break;
+        }
+        offset = next;
+    }
+
+    validSize = offset;
+    return true;
+}
+
+StreamJournal::StreamJournal(const std::filesystem::path& directory,
+                             std::shared_ptr<spdlog::logger> logger,
+                             size_t bufferSize)
+    : m_directory(directory)
+    , m_bufferSize(bufferSize)
+    , m_active(&m_buffers[0])
+    , m_standby(&m_buffers[1])
+    , m_logger(logger)
+{
+    for (Buffer& buffer : m_buffers) {
+        buffer.data = std::make_unique<char[]>(m_bufferSize);
+    }
+}
+
+StreamJournal::~StreamJournal()
+{
+    stop();
+}
+
+void StreamJournal::run()
+{
+    if (!std::filesystem::exists(m_directory)) {
+        std::filesystem::create_directories(m_directory);
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_shouldRun = true;
+    }
+    m_writer = std::thread(std::bind(&StreamJournal::writeLoop, this));
+
+    LOG_INFO("Stream journal writer started, recording to {}.", m_directory.string());
+}
+
+void StreamJournal::stop()
+{
+    if (m_stopped) {
+        return;
+    }
+    m_stopped = true;
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_shouldRun = false;
+    }
+    m_cv.notify_all();
+
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+
+    LOG_INFO("Stream journal closed, {} frames recorded, {} dropped.", recordedCount(), droppedCount());
+}
+
+bool StreamJournal::record(std::string_view frame)
+{
+    // stamp before anything else so the time is as close to the receive as possible
+    int64_t monotonicNs = nanosecondsSinceEpoch(std::chrono::steady_clock::now());
+    int64_t wallNs = nanosecondsSinceEpoch(std::chrono::system_clock::now());
+
+    size_t recordSize = journal::recordSize(frame.size());
+    bool result = false;
+    bool wakeWriter = false;
+    if (frame.size() <= std::numeric_limits<uint32_t>::max()) {
+        std::lock_guard lock(m_mutex);
+        if (m_shouldRun && m_active->size + recordSize <= m_bufferSize) {
+            char* dst = m_active->data.get() + m_active->size;
+
+            journal::RecordHeader header{
+                .length = static_cast<uint32_t>(frame.size()),
+                .reserved = 0,
+                .monotonicNs = monotonicNs,
+                .wallNs = wallNs,
+            };
+            std::memcpy(dst, &header, sizeof(header));
+            std::memcpy(dst + sizeof(header), frame.data(), frame.size());
+            std::memset(dst + sizeof(header) + frame.size(), 0, recordSize - sizeof(header) - frame.size());
+
+            m_active->size += recordSize;
+            result = true;
+            wakeWriter = m_active->size >= m_bufferSize / 2;
+        }
+    }
+
+    if (result) {
+        m_recordedCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+        wakeWriter = true;
+    }
+
+    if (wakeWriter) {
+        m_cv.notify_one();
+    }
+
+    return result;
+}
+
+void StreamJournal::writeLoop()
+{
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_cv.wait_for(lock, FLUSH_INTERVAL, [this] { return !m_shouldRun || m_active->size >= m_bufferSize / 2; });
+        bool shouldRun = m_shouldRun;
+
+        // the standby buffer is always empty here, hand it to record() and write the full one
+        std::swap(m_active, m_standby);
+        lock.unlock();
+
+        if (m_standby->size > 0) {
+            write(*m_standby);
+            m_standby->size = 0;
+        }
+
+        lock.lock();
+        if (!shouldRun) {
+            break;
+        }
+    }
+
+    LOG_DEBUG("Stream journal writer terminated.");
+}
+
+void StreamJournal::write(const Buffer& buffer)
+{
+    // write contiguous runs, a run ends where a record belongs to the next day's file
+    const char* data = buffer.data.get();
+    size_t runBegin = 0;
+    size_t offset = 0;
+    auto writeRun = [&] {
+        // records of a day whose file could not be opened are lost
+        if (m_file.is_open() && offset > runBegin) {
+            m_file.write(data + runBegin, offset - runBegin);
+        }
+        runBegin = offset;
+    };
+
+    while (offset < buffer.size) {
+        journal::RecordHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+
+        if (header.wallNs >= m_fileDayEndNs) {
+            writeRun();
+            openFor(header.wallNs);
+        }
+
+        offset += journal::recordSize(header.length);
+    }
+    writeRun();
+
+    if (m_file.is_open() && !m_file.flush()) {
+        LOG_ERROR("Failed to write stream journal {}.", m_filePath.string());
+        m_file.clear();
+    }
+}
+
+bool StreamJournal::openFor(int64_t wallNs)
+{
+    std::time_t seconds = wallNs / 1'000'000'000;
+    std::tm local;
+    localtime_r(&seconds, &local);
+
+    char filename[32];
+    std::strftime(filename, sizeof(filename), "stream-%Y%m%d.journal", &local);
+
+    // next local midnight, set even if the open fails so we do not retry on every record
+    std::tm nextDay = local;
+    nextDay.tm_mday += 1;
+    nextDay.tm_hour = 0;
+    nextDay.tm_min = 0;
+    nextDay.tm_sec = 0;
+    nextDay.tm_isdst = -1;
+    m_fileDayEndNs = static_cast<int64_t>(std::mktime(&nextDay)) * 1'000'000'000;
+
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_filePath = m_directory / filename;
+
+    // resume an existing journal of the same day, dropping a record the last run did not finish
+    uintmax_t existingSize = 0;
+    if (std::filesystem::exists(m_filePath)) {
+        if (!validJournalSize(m_filePath, existingSize)) {
+            LOG_ERROR("{} exists but is not a stream journal, not recording until the next day.", m_filePath.string());
+            return false;
+        }
+        if (existingSize < std::filesystem::file_size(m_filePath)) {
+            LOG_WARN("Truncating incomplete record at the end of {}.", m_filePath.string());
+            std::filesystem::resize_file(m_filePath, existingSize);
+        }
+    }
+
+    m_file.open(m_filePath, std::ios::binary | std::ios::app);
+    if (!m_file.is_open()) {
+        LOG_ERROR("Unable to open stream journal {}.", m_filePath.string());
+        return false;
+    }
+
+    if (existingSize == 0) {
+        journal::FileHeader fileHeader{};
+        std::memcpy(fileHeader.magic, journal::MAGIC, sizeof(journal::MAGIC));
+        fileHeader.version = journal::VERSION;
+        m_file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    }
+
+    LOG_INFO("Recording stream journal to {}.", m_filePath.string());
+    return true;
+}
+
+} // namespace stockbot
@@ -0,0 +1,87 @@
+#ifndef __STREAM_JOURNAL_H__
+#define __STREAM_JOURNAL_H__
+
+#include "spdlog/logger.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace stockbot {
+
+// Records every raw streamer frame to an append only journal, see journal/journalFormat.h.
+//
+// record() stamps the frame and copies it into a preallocated buffer, a dedicated writer thread
+// swaps the buffers and does the file io, so the streamer thread never waits on the disk. If the
+// writer falls behind and the buffer fills up, frames are dropped and counted rather than
+// blocking the stream. One file per local day: <directory>/stream-YYYYMMDD.journal.
+class StreamJournal
+{
+    struct Buffer {
+        std::unique_ptr<char[]>         data;
+        size_t                          size = 0;
+    };
+
+public:
+    static constexpr size_t             DEFAULT_BUFFER_SIZE = 8 << 20;
+
+                                        StreamJournal(
+                                            const std::filesystem::path& directory,
+                                            std::shared_ptr<spdlog::logger> logger,
+                                            size_t bufferSize = DEFAULT_BUFFER_SIZE
+                                        );
+                                        ~StreamJournal();
+
+    void                                run();
+
+    // Flushes what is buffered and stops the writer. Frames recorded afterwards are dropped.
+    // Called again by the destructor, no-op the second time.
+    void                                stop();
+
+    // called from the streamer thread, false if the frame was dropped
+    bool                                record(std::string_view frame);
+
+    // -- counters since construction
+    uint64_t                            recordedCount() const { return m_recordedCount.load(std::memory_order_relaxed); }
+    uint64_t                            droppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    void                                writeLoop();
+    void                                write(const Buffer& buffer);
+
+    // opens the file of the local day wallNs falls in, appending if it exists
+    bool                                openFor(int64_t wallNs);
+
+private:
+    const std::filesystem::path         m_directory;
+    const size_t                        m_bufferSize;
+
+    // -- double buffer, record() fills m_active, the writer drains m_standby
+    Buffer                              m_buffers[2];
+    Buffer*                             m_active;
+    Buffer*                             m_standby;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_cv;
+    bool                                m_shouldRun = false;
+    bool                                m_stopped = false;
+    std::thread                         m_writer;
+
+    // -- current file, writer thread only
+    std::ofstream                       m_file;
+    std::filesystem::path               m_filePath;
+    int64_t                             m_fileDayEndNs = 0;     // wall clock end of the current file's day
+
+    std::atomic<uint64_t>               m_recordedCount = 0;
+    std::atomic<uint64_t>               m_droppedCount = 0;
+
+    std::shared_ptr<spdlog::logger>     m_logger;
+};
+
+} // namespace stockbot
+
+#endif
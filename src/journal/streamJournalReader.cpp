@@ -0,0 +1,91 @@
+#include "streamJournalReader.h"
+#include "journalFormat.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace stockbot {
+
+StreamJournalReader::~StreamJournalReader()
+{
+    close();
+}
+
+bool StreamJournalReader::open(const std::filesystem::path& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size < static_cast<off_t>(sizeof(journal::FileHeader))) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file referenced
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    // read front to back once
+    ::madvise(data, size, MADV_SEQUENTIAL);
+
+    journal::FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (!journal::isValid(header)) {
+        ::munmap(data, size);
+        return false;
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = size;
+    m_offset = sizeof(journal::FileHeader);
+    return true;
+}
+
+void StreamJournalReader::close()
+{
+    if (m_data) {
+        ::munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+        m_offset = 0;
+    }
+}
+
+bool StreamJournalReader::next(Record& record)
+{
+    if (!m_data || m_offset + sizeof(journal::RecordHeader) > m_size) {
+        return false;
+    }
+
+    journal::RecordHeader header;
+    std::memcpy(&header, m_data + m_offset, sizeof(header));
+
+    size_t recordSize = journal::recordSize(header.length);
+    if (m_offset + recordSize > m_size) {
+        return false;
+    }
+
+    record.monotonicNs = header.monotonicNs;
+    record.wallNs = header.wallNs;
+    record.frame = std::string_view(m_data + m_offset + sizeof(header), header.length);
+
+    m_offset += recordSize;
+    return true;
+}
+
+void StreamJournalReader::rewind()
+{
+    if (m_data) {
+        m_offset = sizeof(journal::FileHeader);
+    }
+}
+
+} // namespace stockbot
@@ -0,0 +1,49 @@
+#ifndef __STREAM_JOURNAL_READER_H__
+#define __STREAM_JOURNAL_READER_H__
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace stockbot {
+
+// Walks a journal written by StreamJournal in place, the file is mapped read only.
+//
+// A record cut short at the end of the file (the recorder was killed) ends the iteration.
+// Frames point into the mapping and stay valid until the reader is closed or destroyed.
+class StreamJournalReader
+{
+public:
+    struct Record {
+        int64_t                         monotonicNs;
+        int64_t                         wallNs;
+        std::string_view                frame;
+    };
+
+                                        StreamJournalReader() = default;
+                                        ~StreamJournalReader();
+
+                                        StreamJournalReader(const StreamJournalReader&) = delete;
+    StreamJournalReader&                operator=(const StreamJournalReader&) = delete;
+
+    // false if the file cannot be mapped or is not a journal
+    bool                                open(const std::filesystem::path& path);
+    void                                close();
+
+    // false at the end of the journal
+    bool                                next(Record& record);
+
+    // back to the first record
+    void                                rewind();
+
+    size_t                              fileSize() const { return m_size; }
+
+private:
+    const char*                         m_data = nullptr;
+    size_t                              m_size = 0;
+    size_t                              m_offset = 0;
+};
+
+} // namespace stockbot
+
+#endif
@@ -29,13 +29,25 @@ int main(int argc, char *argv[])
     ::signal(SIGSEGV, &onSignal);
     ::signal(SIGBUS, &onSignal);
 
-    bool reregisterCommands = argc > 1 &&
-                              !strcmp(argv[1], "reregisterCommands");
+    bool reregisterCommands = false;
+    bool recordStreamJournal = false;
+    bool serveMetrics = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "reregisterCommands")) {
+            reregisterCommands = true;
+        } else if (!strcmp(argv[i], "recordStreamJournal")) {
+            recordStreamJournal = true;
+        } else if (!strcmp(argv[i], "serveMetrics")) {
+            serveMetrics = true;
+        }
+    }
     
     {
         std::shared_ptr<stockbot::App> app = std::make_shared<stockbot::App>(stockbot::App::Spec{
             .logLevel = stockbot::App::LogLevel::Trace,
             .reregisterDiscordBotSlashCommands = reregisterCommands,
+            .recordStreamJournal = recordStreamJournal,
+            .serveMetrics = serveMetrics,
         });
         app->run();
     }
@@ -0,0 +1,142 @@
+#include "metricsServer.h"
+#include "metricsWriter.h"
+#include "utils/logger.h"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <chrono>
+
+#ifdef TARGET_LOGGER
+#undef TARGET_LOGGER
+#endif
+#define TARGET_LOGGER m_logger
+
+namespace stockbot {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+using net::awaitable;
+using net::use_awaitable;
+
+// a client that stops talking is dropped after this
+static constexpr std::chrono::seconds IDLE_TIMEOUT(30);
+
+static awaitable<void> serveScrapes(tcp::socket socket, std::function<std::string()> scrape)
+{
+    beast::tcp_stream stream(std::move(socket));
+    beast::flat_buffer buffer;
+    try {
+        while (true) {
+            http::request<http::empty_body> request;
+            stream.expires_after(IDLE_TIMEOUT);
+            co_await http::async_read(stream, buffer, request, use_awaitable);
+
+            http::response<http::string_body> response;
+            response.version(request.version());
+            response.keep_alive(request.keep_alive());
+            std::string_view target(request.target().data(), request.target().size());
+            if (request.method() == http::verb::get && (target == "/metrics" || target.starts_with("/metrics?"))) {
+                response.result(http::status::ok);
+                response.set(http::field::content_type, "text/plain; version=0.0.4");
+                response.body() = scrape();
+            } else {
+                response.result(http::status::not_found);
+                response.set(http::field::content_type, "text/plain");
+                response.body() = "not found, try /metrics\n";
+            }
+            response.prepare_payload();
+            co_await http::async_write(stream, response, use_awaitable);
+
+            if (!response.keep_alive()) {
+                break;
+            }
+        }
+    } catch (const boost::system::system_error&) {
+        // closed, timed out or not http
+    }
+
+    beast::error_code ec;
+    stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+static awaitable<void> acceptScrapes(tcp::acceptor acceptor, std::function<std::string()> scrape)
+{
+    while (true) {
+        tcp::socket socket = co_await acceptor.async_accept(use_awaitable);
+        net::co_spawn(acceptor.get_executor(), serveScrapes(std::move(socket), scrape), net::detached);
+    }
+}
+
+MetricsServer::MetricsServer(unsigned short port, Collector collector, std::shared_ptr<spdlog::logger> logger)
+    : m_port(port)
+    , m_collector(std::move(collector))
+    , m_logger(logger)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::run()
+{
+    m_ioContext = std::make_unique<net::io_context>(1);
+
+    tcp::acceptor acceptor(*m_ioContext);
+    try {
+        tcp::endpoint endpoint(net::ip::address_v4::loopback(), m_port);
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(net::socket_base::reuse_address(true));
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    } catch (const boost::system::system_error& e) {
+        LOG_ERROR("Unable to listen for metrics scrapes on port {}: {}", m_port, e.what());
+        m_ioContext.reset();
+        return false;
+    }
+
+    // the coroutines outlive this call, they get everything by value
+    net::co_spawn(*m_ioContext, acceptScrapes(std::move(acceptor), [this] { return scrape(); }), net::detached);
+
+    m_thread = std::thread([this] {
+        try {
+            m_ioContext->run();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Metrics server stopped: {}", e.what());
+        }
+    });
+
+    LOG_INFO("Serving metrics on http://127.0.0.1:{}/metrics", m_port);
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (!m_ioContext) {
+        return;
+    }
+
+    // pending scrapes are abandoned, the coroutines are destroyed with the context
+    m_ioContext->stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_ioContext.reset();
+
+    LOG_INFO("Metrics server stopped.");
+}
+
+std::string MetricsServer::scrape()
+{
+    MetricsWriter writer;
+    try {
+        m_collector(writer);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Metrics collection failed: {}", e.what());
+    }
+    return writer.text();
+}
+
+} // namespace stockbot
@@ -0,0 +1,53 @@
+#ifndef __METRICS_SERVER_H__
+#define __METRICS_SERVER_H__
+
+#include "spdlog/logger.h"
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace boost::asio {
+class io_context;
+}
+
+namespace stockbot {
+
+class MetricsWriter;
+
+// Serves GET /metrics for Prometheus scrapes, on 127.0.0.1 only.
+//
+// A single thread accepts the connections and runs the collector once per scrape, so the
+// collector only has to be safe to call from a thread other than the ones it reads from.
+class MetricsServer
+{
+public:
+    using Collector = std::function<void(MetricsWriter&)>;
+
+                                    MetricsServer(
+                                        unsigned short port,
+                                        Collector collector,
+                                        std::shared_ptr<spdlog::logger> logger
+                                    );
+                                    ~MetricsServer();
+
+    // binds the port and starts serving, false when the port can't be bound
+    bool                            run();
+    // no more scrapes once it returns, the collector can go away. No-op the second time.
+    void                            stop();
+
+private:
+    std::string                     scrape();
+
+private:
+    unsigned short                  m_port;
+    Collector                       m_collector;
+    std::unique_ptr<boost::asio::io_context>
+                                    m_ioContext;
+    std::thread                     m_thread;
+
+    std::shared_ptr<spdlog::logger> m_logger;
+};
+
+} // namespace stockbot
+
+#endif
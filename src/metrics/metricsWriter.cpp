@@ -0,0 +1,127 @@
+#include "metricsWriter.h"
+#include "utils/latencyMetrics.h"
+#include <array>
+#include <charconv>
+#include <cmath>
+
+namespace stockbot {
+
+// le bounds of the latency histograms, in ns
+static constexpr std::array<int64_t, 22> LATENCY_BOUNDS_NS = {
+    1'000, 2'500, 5'000,
+    10'000, 25'000, 50'000,
+    100'000, 250'000, 500'000,
+    1'000'000, 2'500'000, 5'000'000,
+    10'000'000, 25'000'000, 50'000'000,
+    100'000'000, 250'000'000, 500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000,
+    10'000'000'000,
+};
+
+void MetricsWriter::counter(std::string_view name, std::string_view help, uint64_t value)
+{
+    header(name, help, "counter");
+    m_text += name;
+    m_text += ' ';
+    appendValue(value);
+    m_text += '\n';
+}
+
+void MetricsWriter::gauge(std::string_view name, std::string_view help, double value)
+{
+    header(name, help, "gauge");
+    m_text += name;
+    m_text += ' ';
+    appendValue(value);
+    m_text += '\n';
+}
+
+void MetricsWriter::latencyHistograms(std::string_view name, std::string_view help, LatencyMetrics& metrics)
+{
+    header(name, help, "histogram");
+
+    for (size_t stage = 0; stage < size_t(LatencyStage::Count); ++stage) {
+        LatencyHistogram::Counts counts{};
+        uint64_t sum = 0;
+        metrics.totals(LatencyStage(stage), counts, sum);
+
+        std::string labels = "stage=\"";
+        labels += toString(LatencyStage(stage));
+        labels += '"';
+
+        // buckets are in ascending order, one pass over them for all the bounds
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (int64_t bound : LATENCY_BOUNDS_NS) {
+            for (; bucket < counts.size() && LatencyHistogram::highestValue(bucket) <= bound; ++bucket) {
+                cumulative += counts[bucket];
+            }
+            m_text += name;
+            m_text += "_bucket{";
+            m_text += labels;
+            m_text += ",le=\"";
+            appendValue(bound / 1e9);
+            m_text += "\"} ";
+            appendValue(cumulative);
+            m_text += '\n';
+        }
+        for (; bucket < counts.size(); ++bucket) {
+            cumulative += counts[bucket];
+        }
+
+        m_text += name;
+        m_text += "_bucket{";
+        m_text += labels;
+        m_text += ",le=\"+Inf\"} ";
+        appendValue(cumulative);
+        m_text += '\n';
+
+        m_text += name;
+        m_text += "_sum{";
+        m_text += labels;
+        m_text += "} ";
+        appendValue(sum / 1e9);
+        m_text += '\n';
+
+        m_text += name;
+        m_text += "_count{";
+        m_text += labels;
+        m_text += "} ";
+        appendValue(cumulative);
+        m_text += '\n';
+    }
+}
+
+void MetricsWriter::header(std::string_view name, std::string_view help, std::string_view type)
+{
+    m_text += "# HELP ";
+    m_text += name;
+    m_text += ' ';
+    m_text += help;
+    m_text += "\n# TYPE ";
+    m_text += name;
+    m_text += ' ';
+    m_text += type;
+    m_text += '\n';
+}
+
+void MetricsWriter::appendValue(double value)
+{
+    if (std::isnan(value)) {
+        m_text += "NaN";
+        return;
+    }
+
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    m_text.append(buffer, end);
+}
+
+void MetricsWriter::appendValue(uint64_t value)
+{
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    m_text.append(buffer, end);
+}
+
+} // namespace stockbot
@@ -0,0 +1,37 @@
+#ifndef __METRICS_WRITER_H__
+#define __METRICS_WRITER_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace stockbot {
+
+class LatencyMetrics;
+
+// Builds one scrape in the Prometheus text exposition format (version 0.0.4).
+class MetricsWriter
+{
+public:
+    void                            counter(std::string_view name, std::string_view help, uint64_t value);
+    void                            gauge(std::string_view name, std::string_view help, double value);
+
+    // One histogram per LatencyStage, in seconds and labeled stage="...". A sample is counted
+    // under the first bound its whole histogram bucket fits in, so the le counts are exact or
+    // at most one bucket (~3%) late.
+    void                            latencyHistograms(std::string_view name, std::string_view help, LatencyMetrics& metrics);
+
+    const std::string&              text() const { return m_text; }
+
+private:
+    void                            header(std::string_view name, std::string_view help, std::string_view type);
+    void                            appendValue(double value);
+    void                            appendValue(uint64_t value);
+
+private:
+    std::string                     m_text;
+};
+
+} // namespace stockbot
+
+#endif
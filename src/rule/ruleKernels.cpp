@@ -0,0 +1,143 @@
+#include "ruleKernels.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STOCKBOT_RULE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace stockbot {
+
+using rep = schwabcpp::clock::rep;
+
+static_assert(sizeof(rep) == sizeof(long long), "the vector kernels compare the trigger times as 64 bit integers");
+
+const char* toString(RuleKernel kernel)
+{
+    switch (kernel) {
+        case RuleKernel::Scalar:    return "scalar";
+        case RuleKernel::Sse:       return "sse4.2";
+        case RuleKernel::Avx2:      return "avx2";
+        case RuleKernel::Best:      return "best";
+    }
+
+    return "unknown";
+}
+
+RuleKernel resolveRuleKernel(RuleKernel kernel)
+{
+#ifdef STOCKBOT_RULE_KERNELS_X86
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    static const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+
+    if (kernel == RuleKernel::Best) {
+        return hasAvx2 ? RuleKernel::Avx2 : hasSse42 ? RuleKernel::Sse : RuleKernel::Scalar;
+    }
+    // never hand out a kernel the cpu can't run
+    if ((kernel == RuleKernel::Avx2 && !hasAvx2) || (kernel == RuleKernel::Sse && !hasSse42)) {
+        return RuleKernel::Scalar;
+    }
+    return kernel;
+#else
+    (void)kernel;
+    return RuleKernel::Scalar;
+#endif
+}
+
+// rules [first, count), used for the tails of the vector kernels too
+static void scalarMasks(const RuleColumns& columns, size_t first, double change, const rep* windowStarts, const RuleMasks& masks)
+{
+    for (size_t i = first; i < columns.count; ++i) {
+        uint64_t bit = uint64_t(1) << (i % 64);
+        size_t word = i / 64;
+        masks.skip[word] |= change >= columns.skipAt[i] ? bit : 0;
+        masks.dip[word] |= change <= columns.averageInAt[i] ? bit : 0;
+        masks.due[word] |= columns.lastTrigger[i] < windowStarts[columns.window[i]] ? bit : 0;
+    }
+}
+
+#ifdef STOCKBOT_RULE_KERNELS_X86
+
+// Compiled for the instruction set through the target attribute, the rest of the tree keeps the
+// baseline flags. Only called after the cpu check in resolveRuleKernel().
+__attribute__((target("sse4.2")))
+static size_t sseMasks(const RuleColumns& columns, double change, const rep* windowStarts, const RuleMasks& masks)
+{
+    const __m128d changes = _mm_set1_pd(change);
+
+    // 2 rules at a time, 32 per mask word
+    size_t i = 0;
+    for (; i + 2 <= columns.count; i += 2) {
+        __m128d skipAt = _mm_loadu_pd(columns.skipAt + i);
+        __m128d averageInAt = _mm_loadu_pd(columns.averageInAt + i);
+        __m128i lastTrigger = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns.lastTrigger + i));
+        // no 64 bit gather before avx2
+        __m128i start = _mm_set_epi64x(windowStarts[columns.window[i + 1]], windowStarts[columns.window[i]]);
+
+        uint64_t skip = _mm_movemask_pd(_mm_cmple_pd(skipAt, changes));
+        uint64_t dip = _mm_movemask_pd(_mm_cmple_pd(changes, averageInAt));
+        uint64_t due = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(start, lastTrigger)));
+
+        unsigned shift = i % 64;
+        masks.skip[i / 64] |= skip << shift;
+        masks.dip[i / 64] |= dip << shift;
+        masks.due[i / 64] |= due << shift;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t avx2Masks(const RuleColumns& columns, double change, const rep* windowStarts, const RuleMasks& masks)
+{
+    const __m256d changes = _mm256_set1_pd(change);
+    const long long* starts = reinterpret_cast<const long long*>(windowStarts);
+
+    // 4 rules at a time, 16 per mask word
+    size_t i = 0;
+    for (; i + 4 <= columns.count; i += 4) {
+        __m256d skipAt = _mm256_loadu_pd(columns.skipAt + i);
+        __m256d averageInAt = _mm256_loadu_pd(columns.averageInAt + i);
+        __m256i lastTrigger = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns.lastTrigger + i));
+
+        int32_t windowBytes;
+        std::memcpy(&windowBytes, columns.window + i, sizeof(windowBytes));
+        __m256i window = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(windowBytes));
+        __m256i start = _mm256_i64gather_epi64(starts, window, sizeof(long long));
+
+        uint64_t skip = _mm256_movemask_pd(_mm256_cmp_pd(skipAt, changes, _CMP_LE_OQ));
+        uint64_t dip = _mm256_movemask_pd(_mm256_cmp_pd(changes, averageInAt, _CMP_LE_OQ));
+        uint64_t due = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(start, lastTrigger)));
+
+        unsigned shift = i % 64;
+        masks.skip[i / 64] |= skip << shift;
+        masks.dip[i / 64] |= dip << shift;
+        masks.due[i / 64] |= due << shift;
+    }
+    return i;
+}
+
+#endif
+
+void computeRuleMasks(RuleKernel kernel,
+                      const RuleColumns& columns,
+                      double change,
+                      const rep* windowStarts,
+                      const RuleMasks& masks)
+{
+    size_t words = (columns.count + 63) / 64;
+    std::memset(masks.skip, 0, words * sizeof(uint64_t));
+    std::memset(masks.dip, 0, words * sizeof(uint64_t));
+    std::memset(masks.due, 0, words * sizeof(uint64_t));
+
+    size_t done = 0;
+    switch (resolveRuleKernel(kernel)) {
+#ifdef STOCKBOT_RULE_KERNELS_X86
+        case RuleKernel::Avx2:  done = avx2Masks(columns, change, windowStarts, masks); break;
+        case RuleKernel::Sse:   done = sseMasks(columns, change, windowStarts, masks); break;
+#endif
+        default: break;
+    }
+    scalarMasks(columns, done, change, windowStarts, masks);
+}
+
+} // namespace stockbot
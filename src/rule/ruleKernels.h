@@ -0,0 +1,49 @@
+#ifndef __RULE_KERNELS_H__
+#define __RULE_KERNELS_H__
+
+#include "schwabcpp/utils/clock.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace stockbot {
+
+// Threshold sweeps behind RuleSet::evaluate, one implementation per instruction set.
+enum class RuleKernel : char {
+    Scalar,
+    Sse,            // SSE4.2, 2 rules per instruction
+    Avx2,           // 4 rules per instruction
+
+    Best,           // the widest the cpu supports
+};
+
+const char* toString(RuleKernel kernel);
+
+// Best resolved for this cpu, Scalar off x86
+RuleKernel resolveRuleKernel(RuleKernel kernel = RuleKernel::Best);
+
+// the threshold columns of a RuleSet
+struct RuleColumns {
+    const double*                       skipAt;
+    const double*                       averageInAt;
+    const uint8_t*                      window;
+    const schwabcpp::clock::rep*        lastTrigger;
+    size_t                              count;
+};
+
+// One bit per rule, rule i is bit i % 64 of word i / 64. Each array has (count + 63) / 64 words,
+// the bits past count come out 0.
+struct RuleMasks {
+    uint64_t*                           skip;       // change >= skipAt
+    uint64_t*                           dip;        // change <= averageInAt
+    uint64_t*                           due;        // lastTrigger < windowStarts[window]
+};
+
+void computeRuleMasks(RuleKernel kernel,
+                      const RuleColumns& columns,
+                      double change,
+                      const schwabcpp::clock::rep* windowStarts,
+                      const RuleMasks& masks);
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,117 @@
+#include "ruleSet.h"
+#include "tradingWindow.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace stockbot {
+
+const char* toString(RuleSignal signal)
+{
+    switch (signal) {
+        case RuleSignal::None:      return "none";
+        case RuleSignal::Buy:       return "buy";
+        case RuleSignal::Skip:      return "skip";
+        case RuleSignal::AverageIn: return "average in";
+    }
+
+    return "unknown";
+}
+
+RuleSet::RuleSet(const std::vector<AutoInvestment>& investments)
+{
+    constexpr double never = std::numeric_limits<double>::infinity();
+
+    size_t count = investments.size();
+    m_skipAt.reserve(count);
+    m_averageInAt.reserve(count);
+    m_window.reserve(count);
+    m_lastTrigger.reserve(count);
+    m_shares.reserve(count);
+    m_extras.reserve(count);
+
+    for (const AutoInvestment& investment : investments) {
+        m_skipAt.push_back(investment.skipThreshold > 0.0 ? investment.skipThreshold : never);
+        m_averageInAt.push_back(investment.averageInThreshold > 0.0 ? -investment.averageInThreshold : -never);
+        m_window.push_back(static_cast<uint8_t>(investment.frequency <= AutoInvestment::Unknown ? investment.frequency : AutoInvestment::Unknown));
+        m_lastTrigger.push_back(std::max(investment.lastTriggerTime, investment.signalledTime));
+        m_shares.push_back(investment.shares);
+        m_extras.push_back(investment.extras);
+    }
+}
+
+size_t RuleSet::evaluate(const RuleInputs& inputs, std::vector<RuleDecision>& out, RuleKernel kernel) const
+{
+    // without a quote every comparison is false, which would read as a plain buy
+    if (std::isnan(inputs.change)) {
+        return 0;
+    }
+    bool rebounded = inputs.rebound >= MIN_REBOUND;
+
+    // reused by every evaluation on this thread
+    thread_local std::vector<uint64_t> skip;
+    thread_local std::vector<uint64_t> dip;
+    thread_local std::vector<uint64_t> due;
+    size_t words = (size() + 63) / 64;
+    skip.resize(words);
+    dip.resize(words);
+    due.resize(words);
+
+    computeRuleMasks(
+        kernel,
+        RuleColumns{ m_skipAt.data(), m_averageInAt.data(), m_window.data(), m_lastTrigger.data(), size() },
+        inputs.change,
+        inputs.windowStarts.data(),
+        RuleMasks{ skip.data(), dip.data(), due.data() }
+    );
+
+    // Down past the threshold without the rebound waits, everything else that is due fires. Once
+    // the windows are consumed due is all zeros and this is a scan of empty words.
+    size_t fired = 0;
+    for (size_t word = 0; word < words; ++word) {
+        uint64_t firing = due[word] & (rebounded ? ~uint64_t(0) : skip[word] | ~dip[word]);
+        for (; firing; firing &= firing - 1) {
+            unsigned bit = std::countr_zero(firing);
+            size_t rule = word * 64 + bit;
+            uint64_t mask = uint64_t(1) << bit;
+
+            RuleSignal signal = skip[word] & mask ? RuleSignal::Skip
+                              : dip[word] & mask  ? RuleSignal::AverageIn
+                                                  : RuleSignal::Buy;
+            out.push_back(RuleDecision{
+                .rule = static_cast<uint32_t>(rule),
+                .signal = signal,
+                .shares = m_shares[rule] + (signal == RuleSignal::AverageIn ? m_extras[rule] : 0),
+            });
+            ++fired;
+        }
+    }
+
+    return fired;
+}
+
+std::array<clock::rep, AutoInvestment::Unknown + 1> RuleSet::windowStarts(clock::time_point now)
+{
+    // called on every evaluation, the time zone conversions only run when a window opens
+    thread_local std::array<clock::rep, AutoInvestment::Unknown + 1> starts;
+    thread_local clock::time_point validFrom = clock::time_point::max();
+    thread_local clock::time_point validUntil = clock::time_point::min();
+    if (now >= validFrom && now < validUntil) {
+        return starts;
+    }
+
+    validFrom = clock::time_point::min();
+    validUntil = clock::time_point::max();
+    for (AutoInvestment::Frequency frequency : { AutoInvestment::Daily, AutoInvestment::Weekly }) {
+        clock::time_point open = windowOpen(frequency, now);
+        starts[frequency] = open.time_since_epoch().count();
+        validFrom = std::max(validFrom, open);
+        validUntil = std::min(validUntil, nextWindowOpen(frequency, now));
+    }
+    // never due
+    starts[AutoInvestment::Unknown] = std::numeric_limits<clock::rep>::min();
+    return starts;
+}
+
+} // namespace stockbot
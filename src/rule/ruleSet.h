@@ -0,0 +1,78 @@
+#ifndef __RULE_SET_H__
+#define __RULE_SET_H__
+
+#include "autoInvestment.h"
+#include "ruleKernels.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace stockbot {
+
+enum class RuleSignal : char {
+    None,
+    Buy,            // the regular purchase of the window
+    Skip,           // up past the skip threshold, the window passes without buying
+    AverageIn,      // down past the average in threshold and rebounded, buy the extras too
+};
+
+const char* toString(RuleSignal signal);
+
+// what the rules are evaluated against, one quote snapshot of the ticker
+struct RuleInputs {
+    double                          change;         // day change as a fraction, 0.01 = up 1%
+    double                          rebound;        // fraction above the day low
+    // start of the current window for every AutoInvestment::Frequency, see windowStarts()
+    std::array<clock::rep, AutoInvestment::Unknown + 1>
+                                    windowStarts;
+};
+
+struct RuleDecision {
+    uint32_t                        rule;           // index in the order the investments were compiled
+    RuleSignal                      signal;
+    int                             shares;
+};
+
+// The AutoInvestments of one ticker compiled for evaluation on every quote.
+//
+// Each investment becomes a row of flat columns (thresholds, window, last trigger, shares). A
+// vector kernel sweeps the columns once and produces skip / dip / due bitmasks for all the rules,
+// then only the rules whose bits fire are visited to build the decisions:
+//   - nothing until the window of the frequency has started since the last trigger or signal
+//   - Skip when the day change is at or above the skip threshold
+//   - AverageIn when at or below minus the average in threshold and rebounded from the low
+//   - nothing while down past the threshold without the rebound, waiting for it
+//   - Buy otherwise
+// Thresholds of 0 disable their condition.
+class RuleSet
+{
+public:
+    // minimum rebound from the day low for averaging in
+    static constexpr double         MIN_REBOUND = 0.0025;
+
+    explicit                        RuleSet(const std::vector<AutoInvestment>& investments);
+
+    size_t                          size() const { return m_shares.size(); }
+
+    // Appends a decision for every rule that fires to out. Returns how many were appended.
+    size_t                          evaluate(const RuleInputs& inputs,
+                                             std::vector<RuleDecision>& out,
+                                             RuleKernel kernel = RuleKernel::Best) const;
+
+    // Window starts for now, see windowOpen(). Cached per thread until a window changes.
+    static std::array<clock::rep, AutoInvestment::Unknown + 1>
+                                    windowStarts(clock::time_point now);
+
+private:
+    // -- one entry per rule
+    std::vector<double>             m_skipAt;           // change >= m_skipAt skips
+    std::vector<double>             m_averageInAt;      // change <= m_averageInAt averages in
+    std::vector<uint8_t>            m_window;           // AutoInvestment::Frequency
+    std::vector<clock::rep>         m_lastTrigger;      // the later of the committed trigger and the last signal
+    std::vector<int>                m_shares;
+    std::vector<int>                m_extras;
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,111 @@
+#include "tradingWindow.h"
+#include <algorithm>
+
+namespace stockbot {
+
+using namespace std::chrono;
+
+static const time_zone* newYork()
+{
+    static const time_zone* zone = locate_zone("America/New_York");
+    return zone;
+}
+
+static local_time<clock::duration> toNewYork(clock::time_point time)
+{
+    return zoned_time{ newYork(), time }.get_local_time();
+}
+
+// the openings are never in a DST transition, no ambiguity
+static clock::time_point fromNewYork(local_time<clock::duration> time)
+{
+    return zoned_time{ newYork(), time }.get_sys_time();
+}
+
+static bool isWeekday(local_days day)
+{
+    weekday wd{ day };
+    return wd != Saturday && wd != Sunday;
+}
+
+static constexpr auto DAILY_OPEN = hours(10);
+static constexpr auto WEEKLY_OPEN = hours(9) + minutes(30);
+
+// the monday of the week of day
+static local_days mondayOf(local_days day)
+{
+    return day - days(weekday{ day }.iso_encoding() - 1);
+}
+
+clock::time_point windowOpen(AutoInvestment::Frequency frequency, clock::time_point now)
+{
+    auto local = toNewYork(now);
+    local_days today = floor<days>(local);
+
+    switch (frequency) {
+        case AutoInvestment::Daily: {
+            local_days day = today;
+            if (!isWeekday(day) || local < day + DAILY_OPEN) {
+                do {
+                    day -= days(1);
+                } while (!isWeekday(day));
+            }
+            return fromNewYork(day + DAILY_OPEN);
+        }
+        case AutoInvestment::Weekly: {
+            local_days monday = mondayOf(today);
+            if (local < monday + WEEKLY_OPEN) {
+                monday -= weeks(1);
+            }
+            return fromNewYork(monday + WEEKLY_OPEN);
+        }
+        case AutoInvestment::Unknown:
+            break;
+    }
+
+    return clock::time_point::min();
+}
+
+clock::time_point nextWindowOpen(AutoInvestment::Frequency frequency, clock::time_point now)
+{
+    auto local = toNewYork(now);
+    local_days today = floor<days>(local);
+
+    switch (frequency) {
+        case AutoInvestment::Daily: {
+            local_days day = today;
+            if (!isWeekday(day) || local >= day + DAILY_OPEN) {
+                do {
+                    day += days(1);
+                } while (!isWeekday(day));
+            }
+            return fromNewYork(day + DAILY_OPEN);
+        }
+        case AutoInvestment::Weekly: {
+            local_days monday = mondayOf(today);
+            if (local >= monday + WEEKLY_OPEN) {
+                monday += weeks(1);
+            }
+            return fromNewYork(monday + WEEKLY_OPEN);
+        }
+        case AutoInvestment::Unknown:
+            break;
+    }
+
+    return clock::time_point::max();
+}
+
+clock::time_point nextTrigger(const AutoInvestment& investment, clock::time_point now)
+{
+    if (investment.frequency != AutoInvestment::Daily && investment.frequency != AutoInvestment::Weekly) {
+        return clock::time_point::max();
+    }
+
+    clock::rep actedOn = std::max(investment.lastTriggerTime, investment.signalledTime);
+    if (actedOn < windowOpen(investment.frequency, now).time_since_epoch().count()) {
+        return now;
+    }
+    return nextWindowOpen(investment.frequency, now);
+}
+
+} // namespace stockbot
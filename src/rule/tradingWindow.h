@@ -0,0 +1,26 @@
+#ifndef __TRADING_WINDOW_H__
+#define __TRADING_WINDOW_H__
+
+#include "autoInvestment.h"
+
+namespace stockbot {
+
+// When the purchase window of every AutoInvestment::Frequency opens, in New York time:
+//   - Daily: 10:00 on weekdays, once the open has settled
+//   - Weekly: the monday open, 09:30
+// Market holidays are not known here, a window opening on one waits for the first tick.
+
+// the opening of the window now falls in, time_point::min() for Unknown
+clock::time_point                   windowOpen(AutoInvestment::Frequency frequency, clock::time_point now);
+// the first opening after now, time_point::max() for Unknown
+clock::time_point                   nextWindowOpen(AutoInvestment::Frequency frequency, clock::time_point now);
+
+// When the investment is next due: now if the current window hasn't been acted on yet (missed
+// while down or before a restart), else the next opening. Acted on is the committed
+// lastTriggerTime, or signalledTime within this run (never cached, so after a restart only what
+// was committed counts).
+clock::time_point                   nextTrigger(const AutoInvestment& investment, clock::time_point now);
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,305 @@
+#include "streamFrameDecoder.h"
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace stockbot {
+
+namespace {
+
+using LevelOneEquity = schwabcpp::StreamerField::LevelOneEquity;
+
+// resolve the numeric keys (the field numbers) through schwabcpp once instead of per field,
+// key < LevelOneFieldSet::CAPACITY
+static LevelOneEquity toLevelOneEquityField(unsigned key)
+{
+    static const std::array<LevelOneEquity, LevelOneFieldSet::CAPACITY> table = [] {
+        std::array<LevelOneEquity, LevelOneFieldSet::CAPACITY> result;
+        for (unsigned i = 0; i < LevelOneFieldSet::CAPACITY; ++i) {
+            result[i] = schwabcpp::StreamerField::toLevelOneEquityField(std::to_string(i));
+        }
+        return result;
+    }();
+
+    return table[key];
+}
+
+// minimal json reader over the raw frame, only supports what the envelope needs
+class Reader
+{
+public:
+    Reader(const char* begin, const char* end) : m_begin(begin), m_cur(begin), m_end(end) {}
+
+    size_t          offset() const { return m_cur - m_begin; }
+    const char*     position() const { return m_cur; }
+
+    void            skipWhitespace()
+                    {
+                        while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\n' || *m_cur == '\r' || *m_cur == '\t')) {
+                            ++m_cur;
+                        }
+                    }
+
+    // consumes c (after whitespace) if it is the next character
+    bool            consume(char c)
+                    {
+                        skipWhitespace();
+                        if (m_cur < m_end && *m_cur == c) {
+                            ++m_cur;
+                            return true;
+                        }
+                        return false;
+                    }
+
+    // raw contents between the quotes, escapes are left as is
+    bool            readString(std::string_view& out)
+                    {
+                        if (!consume('"')) return false;
+
+                        const char* begin = m_cur;
+                        while (true) {
+                            const char* quote = static_cast<const char*>(std::memchr(m_cur, '"', m_end - m_cur));
+                            if (!quote) return false;
+
+                            // the quote is escaped if preceded by an odd number of backslashes
+                            const char* it = quote;
+                            while (it > begin && *(it - 1) == '\\') --it;
+                            m_cur = quote + 1;
+                            if ((quote - it) % 2 == 0) {
+                                out = std::string_view(begin, quote - begin);
+                                return true;
+                            }
+                        }
+                    }
+
+    // "key":
+    bool            readKey(std::string_view& key)
+                    {
+                        return readString(key) && consume(':');
+                    }
+
+    // returns false if the next value is not a number, nothing is consumed in that case
+    bool            readNumber(double& out)
+                    {
+                        skipWhitespace();
+                        if (m_cur >= m_end || !(*m_cur == '-' || (*m_cur >= '0' && *m_cur <= '9'))) return false;
+
+                        auto [ptr, ec] = std::from_chars(m_cur, m_end, out);
+                        if (ec != std::errc()) return false;
+                        m_cur = ptr;
+                        return true;
+                    }
+
+    bool            skipValue()
+                    {
+                        skipWhitespace();
+                        if (m_cur >= m_end) return false;
+
+                        if (*m_cur == '"') {
+                            std::string_view ignored;
+                            return readString(ignored);
+                        }
+
+                        if (*m_cur == '{' || *m_cur == '[') {
+                            int depth = 0;
+                            while (m_cur < m_end) {
+                                char c = *m_cur;
+                                if (c == '"') {
+                                    std::string_view ignored;
+                                    if (!readString(ignored)) return false;
+                                    continue;
+                                }
+                                if (c == '{' || c == '[') {
+                                    ++depth;
+                                } else if (c == '}' || c == ']') {
+                                    if (--depth == 0) {
+                                        ++m_cur;
+                                        return true;
+                                    }
+                                }
+                                ++m_cur;
+                            }
+                            return false;
+                        }
+
+                        // numbers and literals
+                        const char* begin = m_cur;
+                        while (m_cur < m_end &&
+                               *m_cur != ',' && *m_cur != '}' && *m_cur != ']' &&
+                               *m_cur != ' ' && *m_cur != '\n' && *m_cur != '\r' && *m_cur != '\t') {
+                            ++m_cur;
+                        }
+                        return m_cur != begin;
+                    }
+
+private:
+    const char*     m_begin;
+    const char*     m_cur;
+    const char*     m_end;
+};
+
+static bool parseFieldKey(std::string_view key, unsigned& out)
+{
+    if (key.empty()) return false;
+    auto [ptr, ec] = std::from_chars(key.data(), key.data() + key.size(), out);
+    return ec == std::errc() && ptr == key.data() + key.size();
+}
+
+using DecodedEntries = std::vector<std::pair<std::string_view, LevelOneFieldSet>>;
+using UnsupportedServices = std::vector<std::pair<std::string_view, std::string_view>>;
+
+// [ {"key": "AAPL", "delayed": false, "1": 123.4, ...}, ... ]
+static bool decodeLevelOneEquityContent(Reader& reader, DecodedEntries& entries)
+{
+    if (!reader.consume('[')) return false;
+    if (reader.consume(']')) return true;
+
+    do {
+        if (!reader.consume('{')) return false;
+
+        // filled in place, dropped again if it has no ticker
+        auto& [ticker, fields] = entries.emplace_back();
+
+        if (!reader.consume('}')) {
+            do {
+                std::string_view key;
+                if (!reader.readKey(key)) return false;
+
+                unsigned fieldKey;
+                if (key == "key") {
+                    // the ticker
+                    if (!reader.readString(ticker)) return false;
+                } else if (parseFieldKey(key, fieldKey)) {
+                    // subscribed fields, non numeric ones and the ones the field set has no room for are skipped
+                    double value;
+                    if (fieldKey < LevelOneFieldSet::CAPACITY && reader.readNumber(value)) {
+                        fields.set(toLevelOneEquityField(fieldKey), value);
+                    } else if (!reader.skipValue()) {
+                        return false;
+                    }
+                } else {
+                    // the very first response will contain "delayed", "assetMainType", "assetSubType", "cusip"
+                    // in addition to the subscribed fields, ignoring them for now
+                    if (!reader.skipValue()) return false;
+                }
+            } while (reader.consume(','));
+
+            if (!reader.consume('}')) return false;
+        }
+
+        if (ticker.empty()) {
+            entries.pop_back();
+        }
+    } while (reader.consume(','));
+
+    return reader.consume(']');
+}
+
+// {"service": "LEVELONE_EQUITIES", "timestamp": 1715908546054, "command": "SUBS", "content": [...]}
+static bool decodeServiceData(Reader& reader, DecodedEntries& entries, UnsupportedServices& unsupported)
+{
+    if (!reader.consume('{')) return false;
+    if (reader.consume('}')) return true;
+
+    std::string_view service;
+    std::string_view command;
+    bool contentDecoded = false;
+    const char* deferredContentBegin = nullptr;
+    const char* deferredContentEnd = nullptr;
+
+    auto supported = [&] { return service == "LEVELONE_EQUITIES" && command == "SUBS"; };
+
+    do {
+        std::string_view key;
+        if (!reader.readKey(key)) return false;
+
+        if (key == "service") {
+            if (!reader.readString(service)) return false;
+        } else if (key == "command") {
+            if (!reader.readString(command)) return false;
+        } else if (key == "content") {
+            if (supported()) {
+                // the usual case, "content" comes last
+                if (!decodeLevelOneEquityContent(reader, entries)) return false;
+                contentDecoded = true;
+            } else {
+                // don't know yet, remember where it is
+                reader.skipWhitespace();
+                deferredContentBegin = reader.position();
+                if (!reader.skipValue()) return false;
+                deferredContentEnd = reader.position();
+            }
+        } else {
+            if (!reader.skipValue()) return false;
+        }
+    } while (reader.consume(','));
+
+    if (!reader.consume('}')) return false;
+
+    if (supported()) {
+        if (!contentDecoded && deferredContentBegin) {
+            Reader contentReader(deferredContentBegin, deferredContentEnd);
+            if (!decodeLevelOneEquityContent(contentReader, entries)) return false;
+        }
+    } else {
+        unsupported.emplace_back(service, command);
+    }
+
+    return true;
+}
+
+}
+
+StreamFrameDecoder::Status StreamFrameDecoder::decode(std::string_view frame, Handler& handler)
+{
+    Reader reader(frame.data(), frame.data() + frame.size());
+    bool sawData = false;
+
+    // nothing reaches the handler before the whole frame has been decoded
+    m_entries.clear();
+    m_unsupported.clear();
+
+    auto malformed = [&] {
+        m_errorOffset = reader.offset();
+        return Status::Malformed;
+    };
+
+    if (!reader.consume('{')) return malformed();
+
+    if (!reader.consume('}')) {
+        do {
+            std::string_view key;
+            if (!reader.readKey(key)) return malformed();
+
+            // only care about "data" field
+            if (key == "data") {
+                // "data" filed contains a vector of data grouped by the service type
+                if (!reader.consume('[')) return malformed();
+                if (!reader.consume(']')) {
+                    do {
+                        if (!decodeServiceData(reader, m_entries, m_unsupported)) return malformed();
+                    } while (reader.consume(','));
+                    if (!reader.consume(']')) return malformed();
+                }
+                sawData = true;
+            } else {
+                if (!reader.skipValue()) return malformed();
+            }
+        } while (reader.consume(','));
+
+        if (!reader.consume('}')) return malformed();
+    }
+
+    for (const auto& [ticker, fields] : m_entries) {
+        handler.onLevelOneEquity(ticker, fields);
+    }
+    for (const auto& [service, command] : m_unsupported) {
+        handler.onUnsupportedService(service, command);
+    }
+
+    return sawData ? Status::Ok : Status::NoData;
+}
+
+}
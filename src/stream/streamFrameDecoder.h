@@ -0,0 +1,56 @@
+#ifndef __STREAM_FRAME_DECODER_H__
+#define __STREAM_FRAME_DECODER_H__
+
+#include "buffer/levelOneFieldSet.h"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace stockbot {
+
+// Single pass decoder for the schwab streamer envelope.
+//
+// Walks the raw frame once and hands every LEVELONE_EQUITIES content entry to the handler
+// as (ticker, fields). The entries are collected first and handed over only once the whole
+// frame has decoded, a malformed frame reaches the handler not at all. Nothing is allocated
+// once the entry buffer of the decoder has grown to the largest frame, the ticker is a view
+// into the frame and both are only valid during the callback.
+class StreamFrameDecoder
+{
+public:
+    enum class Status : char {
+        Ok,         // frame had a "data" field and was fully decoded
+        NoData,     // well formed but nothing to decode (responses, heartbeats, ...)
+        Malformed,  // stopped at errorOffset()
+    };
+
+    class Handler
+    {
+    public:
+        virtual                             ~Handler() = default;
+
+        virtual void                        onLevelOneEquity(std::string_view ticker, const LevelOneFieldSet& fields) = 0;
+
+        // any service/command combination other than LEVELONE_EQUITIES/SUBS
+        virtual void                        onUnsupportedService(std::string_view, std::string_view) {}
+    };
+
+public:
+    Status                                  decode(std::string_view frame, Handler& handler);
+
+    // position in the frame where decoding stopped, only meaningful after Status::Malformed
+    size_t                                  errorOffset() const { return m_errorOffset; }
+
+private:
+    size_t                                  m_errorOffset = 0;
+
+    // the decoded frame, kept across frames for the capacity
+    std::vector<std::pair<std::string_view, LevelOneFieldSet>>
+                                            m_entries;
+    std::vector<std::pair<std::string_view, std::string_view>>
+                                            m_unsupported;  // service, command
+};
+
+} // namespace stockbot
+
+#endif
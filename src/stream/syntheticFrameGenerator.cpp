@@ -0,0 +1,205 @@
+#include "syntheticFrameGenerator.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace stockbot {
+
+static void appendNumber(std::string& frame, double value)
+{
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 2);
+    frame.append(buffer, end);
+}
+
+static void appendNumber(std::string& frame, int64_t value)
+{
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    frame.append(buffer, end);
+}
+
+// ,"<field>":<value>
+template <typename T>
+static void appendField(std::string& frame, const char* field, T value)
+{
+    frame += ",\"";
+    frame += field;
+    frame += "\":";
+    appendNumber(frame, value);
+}
+
+static void appendStringField(std::string& frame, const char* field, const std::string& value)
+{
+    frame += ",\"";
+    frame += field;
+    frame += "\":\"";
+    frame += value;
+    frame += '"';
+}
+
+// AAA, AAB, ... unique for every index
+static std::string tickerName(size_t index)
+{
+    std::string ticker;
+    do {
+        ticker.insert(ticker.begin(), char('A' + index % 26));
+        index /= 26;
+    } while (index > 0);
+
+    if (ticker.size() < 3) {
+        ticker.insert(0, 3 - ticker.size(), 'A');
+    }
+    return ticker;
+}
+
+SyntheticFrameGenerator::SyntheticFrameGenerator(const Spec& spec)
+    : m_spec(spec)
+    , m_rng(spec.seed)
+{
+    if (!m_spec.tickers.empty()) {
+        m_spec.symbolCount = m_spec.tickers.size();
+    }
+    m_spec.symbolCount = std::max<size_t>(m_spec.symbolCount, 1);
+    m_spec.maxEntriesPerFrame = std::clamp<size_t>(m_spec.maxEntriesPerFrame, 1, m_spec.symbolCount);
+    if (m_spec.updatesPerSecond <= 0.0) {
+        m_spec.updatesPerSecond = 1.0;
+    }
+
+    std::uniform_real_distribution<double> price(5.0, 500.0);
+    std::uniform_int_distribution<int> digit(0, 9);
+    m_symbols.resize(m_spec.symbolCount);
+    for (size_t i = 0; i < m_symbols.size(); ++i) {
+        Symbol& symbol = m_symbols[i];
+        symbol.ticker = i < m_spec.tickers.size() ? m_spec.tickers[i] : tickerName(i);
+        for (int d = 0; d < 9; ++d) {
+            symbol.cusip += char('0' + digit(m_rng));
+        }
+        symbol.close = std::round(price(m_rng) * 100.0) / 100.0;
+        symbol.open = symbol.close;
+        symbol.last = symbol.close;
+        symbol.high = symbol.close;
+        symbol.low = symbol.close;
+
+        m_tickers.push_back(symbol.ticker);
+    }
+}
+
+std::chrono::nanoseconds SyntheticFrameGenerator::next(std::string& frame)
+{
+    std::chrono::nanoseconds due(int64_t(m_entryCount / m_spec.updatesPerSecond * 1e9));
+    int64_t timestampMs = m_spec.startTimestampMs + std::chrono::duration_cast<std::chrono::milliseconds>(due).count();
+
+    // distinct symbols per frame, like the live feed
+    size_t entries = std::uniform_int_distribution<size_t>(1, m_spec.maxEntriesPerFrame)(m_rng);
+    m_picked.clear();
+    while (m_picked.size() < entries) {
+        size_t index = pickSymbol();
+        if (std::find(m_picked.begin(), m_picked.end(), index) == m_picked.end()) {
+            m_picked.push_back(index);
+        }
+    }
+
+    frame.clear();
+    frame += "{\"data\":[{\"service\":\"LEVELONE_EQUITIES\",\"timestamp\":";
+    appendNumber(frame, timestampMs);
+    frame += ",\"command\":\"SUBS\",\"content\":[";
+    for (size_t i = 0; i < m_picked.size(); ++i) {
+        if (i > 0) {
+            frame += ',';
+        }
+        appendEntry(frame, m_symbols[m_picked[i]], timestampMs);
+    }
+    frame += "]}]}";
+
+    m_entryCount += entries;
+    return due;
+}
+
+size_t SyntheticFrameGenerator::pickSymbol()
+{
+    // squaring skews the picks towards the low indices, a few symbols get most of the updates
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(m_rng);
+    return std::min(m_symbols.size() - 1, size_t(u * u * m_symbols.size()));
+}
+
+void SyntheticFrameGenerator::appendEntry(std::string& frame, Symbol& symbol, int64_t timestampMs)
+{
+    frame += "{\"key\":\"";
+    frame += symbol.ticker;
+    frame += '"';
+
+    double spread = std::max(0.01, std::round(symbol.last * 0.0002 * 100.0) / 100.0);
+    std::uniform_int_distribution<int64_t> size(1, 50);
+
+    // first update after the subscription is a full quote
+    if (!symbol.announced) {
+        symbol.announced = true;
+
+        frame += ",\"delayed\":false,\"assetMainType\":\"EQUITY\",\"assetSubType\":\"COE\"";
+        appendStringField(frame, "cusip", symbol.cusip);
+        appendField(frame, "1", symbol.last - spread);
+        appendField(frame, "2", symbol.last + spread);
+        appendField(frame, "3", symbol.last);
+        appendField(frame, "4", size(m_rng));
+        appendField(frame, "5", size(m_rng));
+        appendStringField(frame, "6", "Q");
+        appendStringField(frame, "7", "Q");
+        appendField(frame, "8", int64_t(symbol.volume));
+        appendField(frame, "9", size(m_rng));
+        appendField(frame, "10", symbol.high);
+        appendField(frame, "11", symbol.low);
+        appendField(frame, "12", symbol.close);
+        appendStringField(frame, "13", "Q");
+        frame += ",\"14\":true";
+        appendStringField(frame, "15", symbol.ticker + " Inc");
+        appendField(frame, "17", symbol.open);
+        appendField(frame, "18", symbol.last - symbol.close);
+        appendStringField(frame, "25", "NASDAQ");
+        appendField(frame, "33", symbol.last);
+        appendField(frame, "34", timestampMs);
+        appendField(frame, "35", timestampMs);
+        appendField(frame, "42", (symbol.last - symbol.close) / symbol.close * 100.0);
+        frame += '}';
+        return;
+    }
+
+    // partial update, a trade, a quote change or both
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    bool trade = chance(m_rng) < 0.6;
+    bool quote = !trade || chance(m_rng) < 0.5;
+
+    if (trade) {
+        double step = std::normal_distribution<double>(0.0, symbol.last * 0.0005)(m_rng);
+        symbol.last = std::max(0.01, std::round((symbol.last + step) * 100.0) / 100.0);
+        int64_t lastSize = size(m_rng) * 100;
+        symbol.volume += lastSize;
+
+        appendField(frame, "3", symbol.last);
+        appendField(frame, "8", int64_t(symbol.volume));
+        appendField(frame, "9", lastSize);
+        if (symbol.last > symbol.high) {
+            symbol.high = symbol.last;
+            appendField(frame, "10", symbol.high);
+        }
+        if (symbol.last < symbol.low) {
+            symbol.low = symbol.last;
+            appendField(frame, "11", symbol.low);
+        }
+        appendField(frame, "18", symbol.last - symbol.close);
+        appendField(frame, "35", timestampMs);
+        appendField(frame, "42", (symbol.last - symbol.close) / symbol.close * 100.0);
+    }
+
+    if (quote) {
+        appendField(frame, "1", symbol.last - spread);
+        appendField(frame, "2", symbol.last + spread);
+        appendField(frame, "4", size(m_rng));
+        appendField(frame, "5", size(m_rng));
+        appendField(frame, "34", timestampMs);
+    }
+
+    frame += '}';
+}
+
+} // namespace stockbot
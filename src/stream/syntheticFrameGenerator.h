@@ -0,0 +1,69 @@
+#ifndef __SYNTHETIC_FRAME_GENERATOR_H__
+#define __SYNTHETIC_FRAME_GENERATOR_H__
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace stockbot {
+
+// Generates LEVELONE_EQUITIES streamer frames for load tests.
+//
+// The first update of a symbol is a full quote with the delayed / assetMainType /
+// assetSubType / cusip keys the live feed sends on subscription. Later updates only carry the
+// fields that changed: a random walk of the trade and quote sides, with the high / low fields
+// only when they move. Updates are skewed towards a few hot symbols and the frame timestamps
+// advance at the configured update rate.
+class SyntheticFrameGenerator
+{
+    struct Symbol {
+        std::string                 ticker;
+        std::string                 cusip;
+        bool                        announced = false;
+        double                      close;
+        double                      open;
+        double                      last;
+        double                      high;
+        double                      low;
+        double                      volume = 0.0;
+    };
+
+public:
+    struct Spec {
+        size_t                      symbolCount = 100;              // named AAA, AAB, ...
+        std::vector<std::string>    tickers{};                      // used instead of symbolCount when set
+        double                      updatesPerSecond = 10000.0;     // content entries per second
+        size_t                      maxEntriesPerFrame = 8;         // each frame has 1 - max entries
+        uint64_t                    seed = 1;
+        int64_t                     startTimestampMs = 1715908546054; // frame timestamp of the first frame (epoch ms)
+    };
+
+    explicit                        SyntheticFrameGenerator(const Spec& spec);
+
+    // Writes the next frame, reusing the capacity of frame. Returns when the frame is due at the
+    // configured rate, relative to the first frame.
+    std::chrono::nanoseconds        next(std::string& frame);
+
+    const std::vector<std::string>& tickers() const { return m_tickers; }
+
+    // content entries generated so far
+    uint64_t                        entryCount() const { return m_entryCount; }
+
+private:
+    size_t                          pickSymbol();
+    void                            appendEntry(std::string& frame, Symbol& symbol, int64_t timestampMs);
+
+private:
+    Spec                            m_spec;
+    std::mt19937_64                 m_rng;
+    std::vector<Symbol>             m_symbols;
+    std::vector<std::string>        m_tickers;
+    std::vector<size_t>             m_picked;               // symbols of the frame being built
+    uint64_t                        m_entryCount = 0;
+};
+
+} // namespace stockbot
+
+#endif
@@ -1,5 +1,9 @@
 #include "taskManager.h"
+#include "utils/latencyMetrics.h"
 #include "utils/logger.h"
+#include "utils/timing.h"
+#include <algorithm>
+#include <chrono>
 
 #ifdef TARGET_LOGGER
 #undef TARGET_LOGGER
@@ -8,44 +12,312 @@
 
 namespace stockbot {
 
-TaskManager::TaskManager(int poolSize,
+static_assert(size_t(LatencyStage::NormalTaskWait) == size_t(LatencyStage::CriticalTaskWait) + size_t(TaskPriority::Normal) &&
+              size_t(LatencyStage::BackgroundTaskWait) == size_t(LatencyStage::CriticalTaskWait) + size_t(TaskPriority::Background),
+              "the task wait stages follow the TaskPriority order");
+
+TaskManager::TaskManager(const Spec& spec,
                          std::shared_ptr<spdlog::logger> logger)
-    : m_logger(logger)
+    : m_dispatch(spec.dispatch)
+    , m_laneWeights(spec.laneWeights)
+    , m_timers(monotonicNowNs())
+    , m_timerWakeNs(TimerWheel<ScheduledTask>::NEVER)
+    , m_logger(logger)
 {
-    m_threadPool.resize(poolSize);
+    for (auto& queue : m_injectQueues) {
+        queue = std::make_unique<RingQueue<QueuedTask>>(INJECT_QUEUE_CAPACITY);
+    }
+
+    int poolSize = spec.poolSize;
+    if (poolSize <= 0) {
+        poolSize = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+
+    for (int i = 0; i < poolSize; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+        m_workers.back()->pool = this;
+        m_workers.back()->rng = 0x9e3779b97f4a7c15ull * (i + 1);
+        m_workers.back()->credits = m_laneWeights;
+    }
 }
 
 TaskManager::~TaskManager()
 {
-    m_taskQueue.shutdown();
+    stop();
+}
+
+void TaskManager::stop()
+{
+    // queued tasks still run before the workers exit, unless they expire
+    {
+        std::lock_guard lock(m_timerMutex);
+        m_stopping.store(true);
+    }
+    m_timerCv.notify_all();
+    m_parker.notifyAll();
+
+    if (m_timerThread.joinable()) {
+        m_timerThread.join();
+    }
 
-    for (auto& worker : m_threadPool) {
-        if (worker.joinable()) {
-            worker.join();
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
         }
     }
 }
 
 void TaskManager::run()
 {
-    for (auto& worker : m_threadPool) {
-        LOG_DEBUG("Launching worker...");
-        worker = std::thread(
-            [this]{
-                Task task;
-                while (m_taskQueue.pop(task)) {
-                    task();
+    LOG_DEBUG("Launching {} workers...", m_workers.size());
+    for (auto& worker : m_workers) {
+        worker->thread = std::thread(&TaskManager::workerLoop, this, std::ref(*worker));
+    }
+    m_timerThread = std::thread(&TaskManager::timerLoop, this);
+}
+
+bool TaskManager::addTask(Task task, const TaskOptions& options)
+{
+    // the workers don't exit while an add that got past the check hasn't queued its task
+    m_addsInFlight.fetch_add(1);
+    if (m_stopping.load()) {
+        m_addsInFlight.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    size_t lane = size_t(options.priority);
+    Worker* worker = currentWorker();
+    if (worker && worker->pool == this) {
+        // fan out from a task, stays on this worker unless someone steals it
+        worker->deques[lane].push(acquireNode(std::move(task), options.deadlineNs));
+    } else {
+        m_injectQueues[lane]->push(QueuedTask{ std::move(task), monotonicNowNs(), options.deadlineNs });
+    }
+    m_addsInFlight.fetch_sub(1, std::memory_order_release);
+    m_parker.notifyOne();
+    return true;
+}
+
+TimerId TaskManager::addTimer(int64_t dueNs, Task task, const TaskOptions& options)
+{
+    std::lock_guard lock(m_timerMutex);
+    if (m_stopping.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    TimerId id = m_timers.schedule(dueNs, ScheduledTask{ std::move(task), options, dueNs });
+    // only when it has to wake up earlier than planned
+    if (m_timers.nextEventNs() < m_timerWakeNs) {
+        m_timerCv.notify_one();
+    }
+    return id;
+}
+
+bool TaskManager::cancelTimer(TimerId id)
+{
+    std::lock_guard lock(m_timerMutex);
+    return m_timers.cancel(id);
+}
+
+size_t TaskManager::timerCount() const
+{
+    std::lock_guard lock(m_timerMutex);
+    return m_timers.size();
+}
+
+size_t TaskManager::queuedCount() const
+{
+    size_t count = 0;
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+        count += queuedCount(TaskPriority(lane));
+    }
+    return count;
+}
+
+size_t TaskManager::queuedCount(TaskPriority priority) const
+{
+    size_t lane = size_t(priority);
+    size_t count = m_injectQueues[lane]->size();
+    for (const auto& worker : m_workers) {
+        count += worker->deques[lane].size();
+    }
+    return count;
+}
+
+void TaskManager::workerLoop(Worker& self)
+{
+    currentWorker() = &self;
+
+    LatencyMetrics& metrics = LatencyMetrics::instance();
+    QueuedTask injected;
+    size_t lane;
+    while (true) {
+        if (QueuedTask* queued = findTask(self, injected, lane)) {
+            int64_t startNs = monotonicNowNs();
+            metrics.record(LatencyStage(size_t(LatencyStage::CriticalTaskWait) + lane), startNs - queued->queuedNs);
+            if (queued->deadlineNs == 0 || startNs <= queued->deadlineNs) {
+                queued->task();
+                metrics.record(LatencyStage::TaskRun, monotonicNowNs() - startNs);
+            } else {
+                m_expired[lane].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // drops the capture now, not when the slot or node is reused
+            queued->task = nullptr;
+            if (queued != &injected) {
+                releaseNode(queued);
+            }
+            continue;
+        }
+
+        m_parker.wait([this] { return m_stopping.load(std::memory_order_acquire) || hasQueuedTasks(); });
+        // seq_cst against the increment in addTask
+        if (m_stopping.load() && m_addsInFlight.load() == 0 && !hasQueuedTasks()) {
+            break;
+        }
+    }
+
+    currentWorker() = nullptr;
+    LOG_DEBUG("Worker terminated.");
+}
+
+TaskManager::QueuedTask* TaskManager::acquireNode(Task&& task, int64_t deadlineNs)
+{
+    // allocates only until the cache of the thread is warm
+    auto& cache = nodeCache();
+    std::unique_ptr<QueuedTask> node;
+    if (cache.empty()) {
+        node = std::make_unique<QueuedTask>();
+    } else {
+        node = std::move(cache.back());
+        cache.pop_back();
+    }
+
+    node->task = std::move(task);
+    node->queuedNs = monotonicNowNs();
+    node->deadlineNs = deadlineNs;
+    return node.release();
+}
+
+void TaskManager::releaseNode(QueuedTask* node)
+{
+    auto& cache = nodeCache();
+    if (cache.size() < NODE_CACHE_CAPACITY) {
+        cache.emplace_back(node);
+    } else {
+        delete node;
+    }
+}
+
+TaskManager::QueuedTask* TaskManager::findTask(Worker& self, QueuedTask& injected, size_t& lane)
+{
+    if (m_dispatch == TaskDispatch::Weighted) {
+        // a lane without work gives up the rest of its turn, the round ends once no lane with
+        // credits left has work
+        for (lane = 0; lane < LANE_COUNT; ++lane) {
+            if (self.credits[lane] > 0) {
+                if (QueuedTask* task = findTask(self, lane, injected)) {
+                    --self.credits[lane];
+                    return task;
                 }
+            }
+        }
+        self.credits = m_laneWeights;
+    }
 
-                LOG_DEBUG("Worker terminated.");
+    for (lane = 0; lane < LANE_COUNT; ++lane) {
+        if (QueuedTask* task = findTask(self, lane, injected)) {
+            if (self.credits[lane] > 0) {
+                --self.credits[lane];
             }
-        );
+            return task;
+        }
     }
+    return nullptr;
 }
 
-void TaskManager::addTask(Task task)
+TaskManager::QueuedTask* TaskManager::findTask(Worker& self, size_t lane, QueuedTask& injected)
 {
-    m_taskQueue.push(task);
+    // own work first, the most recent is the warmest
+    QueuedTask* owned;
+    if (self.deques[lane].size() > 0 && self.deques[lane].pop(owned)) {
+        return owned;
+    }
+
+    if (m_injectQueues[lane]->size() > 0 && m_injectQueues[lane]->tryPop(injected)) {
+        return &injected;
+    }
+
+    // steal, starting from a random victim so the thieves spread out
+    size_t count = m_workers.size();
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 7;
+    self.rng ^= self.rng << 17;
+    size_t start = self.rng % count;
+    for (size_t i = 0; i < count; ++i) {
+        Worker& victim = *m_workers[(start + i) % count];
+        if (&victim != &self && victim.deques[lane].size() > 0 && victim.deques[lane].steal(owned)) {
+            return owned;
+        }
+    }
+    return nullptr;
+}
+
+bool TaskManager::hasQueuedTasks() const
+{
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+        if (m_injectQueues[lane]->size() > 0) {
+            return true;
+        }
+        for (const auto& worker : m_workers) {
+            if (worker->deques[lane].size() > 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskManager::timerLoop()
+{
+    using namespace std::chrono;
+    constexpr int64_t never = TimerWheel<ScheduledTask>::NEVER;
+
+    LatencyMetrics& metrics = LatencyMetrics::instance();
+    std::vector<ScheduledTask> fired;
+    std::unique_lock lock(m_timerMutex);
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        int64_t dueNs = m_timers.nextEventNs();
+        int64_t nowNs = monotonicNowNs();
+        if (dueNs > nowNs) {
+            if (dueNs - nowNs > TIMER_SPIN_NS) {
+                // woken early by a sooner timer or the destructor, then look again
+                m_timerWakeNs = dueNs;
+                if (dueNs == never) {
+                    m_timerCv.wait(lock);
+                } else {
+                    m_timerCv.wait_until(lock, steady_clock::time_point(nanoseconds(dueNs - TIMER_SPIN_NS)));
+                }
+                m_timerWakeNs = never;
+                continue;
+            }
+
+            lock.unlock();
+            while (monotonicNowNs() < dueNs) {
+                std::this_thread::yield();
+            }
+            lock.lock();
+            continue;
+        }
+
+        m_timers.advance(nowNs, fired);
+        lock.unlock();
+        for (ScheduledTask& scheduled : fired) {
+            metrics.record(LatencyStage::TimerLate, monotonicNowNs() - scheduled.dueNs);
+            addTask(std::move(scheduled.task), scheduled.options);
+        }
+        fired.clear();
+        lock.lock();
+    }
 }
 
 }
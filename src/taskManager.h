@@ -2,29 +2,153 @@
 #define __TASK_MANAGER_H__
 
 #include "spdlog/logger.h"
-#include <utils/concurrentQueue.h>
+#include "taskOptions.h"
+#include "utils/parker.h"
+#include "utils/ringQueue.h"
+#include "utils/timerWheel.h"
+#include "utils/workStealingDeque.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <memory>
 #include <vector>
 #include <thread>
-#include <functional>
 
 namespace stockbot {
 
+// how the workers pick between the lanes that have work
+enum class TaskDispatch : char {
+    Strict,         // always the highest priority lane
+    Weighted,       // every lane gets its weight in tasks per round, no lane starves
+};
+
+// Work stealing thread pool with one lane per TaskPriority.
+//
+// Every worker owns a deque per lane. Tasks added from a worker go to its own deque and run LIFO
+// on the same thread; tasks added from anywhere else go through the shared inject queue of their
+// lane. A worker out of local work takes from the inject queue, then steals the oldest task of
+// another worker, and parks once there is nothing left anywhere. The lanes are visited in the
+// order the dispatch policy gives, a queued task past its deadline is dropped.
+//
+// Timers: a task can be scheduled for a later time. A timer thread keeps them in a timer wheel,
+// sleeps until the next one is due, spins the last stretch for sub millisecond precision and
+// then adds the task to its lane like any other.
 class TaskManager
 {
-    using Task = std::function<void()>;
+    static constexpr size_t     LANE_COUNT = size_t(TaskPriority::Count);
+
+    struct QueuedTask {
+        Task                    task;
+        int64_t                 queuedNs = 0;           // monotonicNowNs()
+        int64_t                 deadlineNs = 0;
+    };
+
+    struct ScheduledTask {
+        Task                    task;
+        TaskOptions             options;
+        int64_t                 dueNs = 0;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Worker {
+        const TaskManager*      pool;
+        std::array<WorkStealingDeque<QueuedTask*>, LANE_COUNT>
+                                deques;                 // owned tasks, released by whoever runs them
+        std::thread             thread;
+        uint64_t                rng;                    // victim selection, worker thread only
+        std::array<unsigned, LANE_COUNT>
+                                credits{};              // weighted dispatch, tasks left in the round
+    };
+
 public:
+    struct Spec {
+        int                     poolSize = 0;           // <= 0: hardware concurrency
+        TaskDispatch            dispatch = TaskDispatch::Strict;
+        std::array<unsigned, LANE_COUNT>
+                                laneWeights = { 16, 4, 1 };     // weighted dispatch, by TaskPriority
+    };
+
                                 TaskManager(
-                                    int poolSize,
+                                    const Spec& spec,
                                     std::shared_ptr<spdlog::logger> logger
                                 );
                                 ~TaskManager();
 
     void                        run();
-    void                        addTask(Task task);
+    // Stops taking work, runs what is still queued and joins the threads. Call it while the
+    // owner's pointer to the pool is still valid, the queued tasks may call back into it.
+    void                        stop();
+    // false once stop() has begun, the task is dropped
+    bool                        addTask(Task task, const TaskOptions& options = {});
+
+    size_t                      poolSize() const { return m_workers.size(); }
+
+    // tasks waiting for a worker, approximate
+    size_t                      queuedCount() const;
+    size_t                      queuedCount(TaskPriority priority) const;
+
+    // tasks dropped because they were still queued at their deadline
+    uint64_t                    expiredCount(TaskPriority priority) const { return m_expired[size_t(priority)].load(std::memory_order_relaxed); }
+
+    // -- timers, dueNs is monotonicNowNs(). Timers still pending at stop() never run, 0 once stop() has begun.
+    TimerId                     addTimer(int64_t dueNs, Task task, const TaskOptions& options = {});
+    // false if the task was already queued or the timer cancelled
+    bool                        cancelTimer(TimerId id);
+    size_t                      timerCount() const;
 
 private:
-    ConcurrentQueue<Task>       m_taskQueue;
-    std::vector<std::thread>    m_threadPool;
+    // the worker the current thread is, of any pool
+    static Worker*&             currentWorker()
+                                {
+                                    thread_local Worker* worker = nullptr;
+                                    return worker;
+                                }
+
+    void                        workerLoop(Worker& self);
+    // recycled deque nodes of this thread, a node goes back to the thread that ran it
+    static std::vector<std::unique_ptr<QueuedTask>>&
+                                nodeCache()
+                                {
+                                    thread_local std::vector<std::unique_ptr<QueuedTask>> cache;
+                                    return cache;
+                                }
+    static QueuedTask*          acquireNode(Task&& task, int64_t deadlineNs);
+    static void                 releaseNode(QueuedTask* node);
+
+    // a deque node the caller releases, or injected moved out of an inject queue
+    QueuedTask*                 findTask(Worker& self, QueuedTask& injected, size_t& lane);
+    QueuedTask*                 findTask(Worker& self, size_t lane, QueuedTask& injected);
+    bool                        hasQueuedTasks() const;
+
+    void                        timerLoop();
+
+private:
+    static constexpr size_t     INJECT_QUEUE_CAPACITY = 1 << 13;
+    static constexpr size_t     NODE_CACHE_CAPACITY = 1024;     // per thread
+    // the end of a timer wait is spun, the condition variable oversleeps by up to ~100us
+    static constexpr int64_t    TIMER_SPIN_NS = 200'000;
+
+    const TaskDispatch          m_dispatch;
+    const std::array<unsigned, LANE_COUNT>
+                                m_laneWeights;
+
+    // tasks added from outside of the pool, by lane
+    std::array<std::unique_ptr<RingQueue<QueuedTask>>, LANE_COUNT>
+                                m_injectQueues;
+    std::vector<std::unique_ptr<Worker>>
+                                m_workers;
+    Parker                      m_parker;               // idle workers
+    std::atomic<bool>           m_stopping = false;
+    std::atomic<size_t>         m_addsInFlight = 0;     // addTask calls past the m_stopping check
+    std::array<std::atomic<uint64_t>, LANE_COUNT>
+                                m_expired{};
+
+    // -- timers
+    mutable std::mutex          m_timerMutex;
+    std::condition_variable     m_timerCv;
+    TimerWheel<ScheduledTask>   m_timers;               // guarded by m_timerMutex
+    int64_t                     m_timerWakeNs;          // when the timer thread wakes up, guarded
+    std::thread                 m_timerThread;
 
     std::shared_ptr<spdlog::logger>     m_logger;
 };
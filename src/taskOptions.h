@@ -0,0 +1,49 @@
+#ifndef __TASK_OPTIONS_H__
+#define __TASK_OPTIONS_H__
+
+#include "utils/inplaceTask.h"
+#include <cstdint>
+
+namespace stockbot {
+
+// scheduling lanes of the task manager, highest priority first
+enum class TaskPriority : char {
+    Critical,       // order placement, anything a user or the broker is waiting on
+    Normal,         // per tick analysis
+    Background,     // housekeeping, fine to run late or not at all
+
+    Count,
+};
+
+inline const char* toString(TaskPriority priority)
+{
+    switch (priority) {
+        case TaskPriority::Critical:    return "critical";
+        case TaskPriority::Normal:      return "normal";
+        case TaskPriority::Background:  return "background";
+        case TaskPriority::Count:       break;
+    }
+
+    return "unknown";
+}
+
+// Inline capture budget of a task, the task is a cache line with its vtable pointer. Captures
+// that don't fit fail to compile, see InplaceTask.
+constexpr size_t                    TASK_CAPTURE_SIZE = 56;
+using Task = InplaceTask<TASK_CAPTURE_SIZE>;
+
+// handle of a task scheduled for later, 0 is never a valid one
+using TimerId = uint64_t;
+
+struct TaskOptions {
+    TaskPriority                    priority = TaskPriority::Normal;
+    // monotonicNowNs(), a task still queued past it is dropped instead of run late. 0: none
+    // Dropped means destroyed without being called: whatever the task would have cleaned up or
+    // rescheduled stays as is (e.g. the per tick task finishing EquityDataBuffer's task state).
+    // Only give a deadline to tasks that leave nothing behind when skipped.
+    int64_t                         deadlineNs = 0;
+};
+
+} // namespace stockbot
+
+#endif
@@ -1,12 +1,19 @@
 #ifndef __CONCURRENT_QUEUE_H__
 #define __CONCURRENT_QUEUE_H__
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
 
 namespace stockbot {
 
+// what pop() does with the items left in the queue after shutdown()
+enum class ShutdownMode : char {
+    Discard,    // pop() returns false right away
+    Drain,      // pop() keeps returning the remaining items, then false
+};
+
 template <typename T>
 class ConcurrentQueue
 {
@@ -20,42 +27,124 @@ public:
                                 m_cv.notify_one();
                             }
 
+    void                    push(T&& data)
+                            {
+                                {
+                                    std::lock_guard lock(m_mutex);
+                                    m_queue.push(std::move(data));
+                                }
+                                m_cv.notify_one();
+                            }
+
+    template <typename... Args>
+    void                    emplace(Args&&... args)
+                            {
+                                {
+                                    std::lock_guard lock(m_mutex);
+                                    m_queue.emplace(std::forward<Args>(args)...);
+                                }
+                                m_cv.notify_one();
+                            }
+
+    // one lock for the whole range, pass move iterators to avoid the copies
+    template <typename InputIt>
+    void                    pushBulk(InputIt first, InputIt last)
+                            {
+                                {
+                                    std::lock_guard lock(m_mutex);
+                                    for (; first != last; ++first) {
+                                        m_queue.push(*first);
+                                    }
+                                }
+                                m_cv.notify_all();
+                            }
+
     bool                    pop(T& data)
                             {
                                 std::unique_lock lock(m_mutex);
                                 m_cv.wait(lock, [this] { return !m_shouldRun || !m_queue.empty(); });
 
-                                // discarding all objects when signaled to exit
-                                bool result = false;
-                                if (m_shouldRun && !m_queue.empty()) {
-                                    data = m_queue.front();
-                                    m_queue.pop();
-                                    result = true;
+                                return popLocked(data);
+                            }
+
+    // false if nothing arrived within the timeout
+    template <typename Rep, typename Period>
+    bool                    popFor(T& data, const std::chrono::duration<Rep, Period>& timeout)
+                            {
+                                std::unique_lock lock(m_mutex);
+                                m_cv.wait_for(lock, timeout, [this] { return !m_shouldRun || !m_queue.empty(); });
+
+                                return popLocked(data);
+                            }
+
+    // never blocks
+    bool                    tryPop(T& data)
+                            {
+                                std::lock_guard lock(m_mutex);
+                                return popLocked(data);
+                            }
+
+    // Blocks until there is something to pop, then moves up to maxCount items to out under a
+    // single lock. Returns the number of items popped, 0 means the queue was shut down.
+    template <typename OutputIt>
+    size_t                  popBulk(OutputIt out, size_t maxCount)
+                            {
+                                std::unique_lock lock(m_mutex);
+                                m_cv.wait(lock, [this] { return !m_shouldRun || !m_queue.empty(); });
+
+                                size_t count = 0;
+                                if (m_shouldRun || m_shutdownMode == ShutdownMode::Drain) {
+                                    for (; count < maxCount && !m_queue.empty(); ++count) {
+                                        *out++ = std::move(m_queue.front());
+                                        m_queue.pop();
+                                    }
                                 }
 
-                                return result;
+                                return count;
                             }
 
-    void                    shutdown()
+    void                    shutdown(ShutdownMode mode = ShutdownMode::Discard)
                             {
                                 {
                                     std::lock_guard lock(m_mutex);
                                     m_shouldRun = false;
+                                    m_shutdownMode = mode;
                                 }
                                 m_cv.notify_all();
                             }
 
+    size_t                  size() const
+                            {
+                                std::lock_guard lock(m_mutex);
+                                return m_queue.size();
+                            }
+
     void                    takeSnapshot(std::queue<T>& data)
                             {
                                 std::lock_guard lock(m_mutex);
                                 data = m_queue;
                             }
 
+private:
+    bool                    popLocked(T& data)
+                            {
+                                // discarding all objects when signaled to exit, unless draining
+                                bool result = false;
+                                if ((m_shouldRun || m_shutdownMode == ShutdownMode::Drain) && !m_queue.empty()) {
+                                    data = std::move(m_queue.front());
+                                    m_queue.pop();
+                                    result = true;
+                                }
+
+                                return result;
+                            }
+
 private:
     std::queue<T>           m_queue;
-    std::mutex              m_mutex;
+    mutable std::mutex      m_mutex;
     std::condition_variable m_cv;
     bool                    m_shouldRun = true;
+    ShutdownMode            m_shutdownMode = ShutdownMode::Discard;
 
 };
 
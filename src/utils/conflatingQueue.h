@@ -0,0 +1,159 @@
+#ifndef __CONFLATING_QUEUE_H__
+#define __CONFLATING_QUEUE_H__
+
+#include "utils/concurrentQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace stockbot {
+
+// Keyed queue that keeps at most one pending item per key.
+//
+// Pushing to a key that is still pending merges the new item into the pending one
+// (T::merge(const T&)) instead of queueing it again, so the depth is bounded by the number of
+// keys rather than by the push rate. Keys are popped in the order they first became pending.
+// Keys are expected to be dense (SymbolId), the slots grow to the largest key seen.
+template <typename T>
+class ConflatingQueue
+{
+    struct Slot {
+        bool                pending = false;
+        T                   data;
+    };
+
+public:
+    // returns true if the item was merged into a pending one
+    bool                    push(size_t key, const T& data)
+                            {
+                                bool conflated;
+                                {
+                                    std::lock_guard lock(m_mutex);
+                                    if (key >= m_slots.size()) {
+                                        grow(key + 1);
+                                    }
+
+                                    Slot& slot = m_slots[key];
+                                    conflated = slot.pending;
+                                    if (conflated) {
+                                        slot.data.merge(data);
+                                    } else {
+                                        slot.data = data;
+                                        slot.pending = true;
+                                        m_order[(m_head + m_pendingCount) % m_order.size()] = key;
+                                        ++m_pendingCount;
+                                    }
+                                }
+
+                                m_pushedCount.fetch_add(1, std::memory_order_relaxed);
+                                if (conflated) {
+                                    m_conflatedCount.fetch_add(1, std::memory_order_relaxed);
+                                } else {
+                                    m_cv.notify_one();
+                                }
+
+                                return conflated;
+                            }
+
+    bool                    pop(size_t& key, T& data)
+                            {
+                                std::unique_lock lock(m_mutex);
+                                m_cv.wait(lock, [this] { return !m_shouldRun || m_pendingCount > 0; });
+
+                                // discarding all objects when signaled to exit, unless draining
+                                bool result = false;
+                                if ((m_shouldRun || m_shutdownMode == ShutdownMode::Drain) && m_pendingCount > 0) {
+                                    key = m_order[m_head];
+                                    m_head = (m_head + 1) % m_order.size();
+                                    --m_pendingCount;
+
+                                    Slot& slot = m_slots[key];
+                                    data = slot.data;
+                                    slot.pending = false;
+                                    result = true;
+                                }
+
+                                return result;
+                            }
+
+    // Pops up to maxCount items in one go, the keys are not reported (T carries its own).
+    // Blocks like pop() and returns 0 once it would return false.
+    template <typename OutputIt>
+    size_t                  popBulk(OutputIt out, size_t maxCount)
+                            {
+                                std::unique_lock lock(m_mutex);
+                                m_cv.wait(lock, [this] { return !m_shouldRun || m_pendingCount > 0; });
+
+                                size_t count = 0;
+                                if (m_shouldRun || m_shutdownMode == ShutdownMode::Drain) {
+                                    for (; count < maxCount && m_pendingCount > 0; ++count) {
+                                        Slot& slot = m_slots[m_order[m_head]];
+                                        m_head = (m_head + 1) % m_order.size();
+                                        --m_pendingCount;
+
+                                        *out++ = slot.data;
+                                        slot.pending = false;
+                                    }
+                                }
+
+                                return count;
+                            }
+
+    void                    shutdown(ShutdownMode mode = ShutdownMode::Discard)
+                            {
+                                {
+                                    std::lock_guard lock(m_mutex);
+                                    m_shouldRun = false;
+                                    m_shutdownMode = mode;
+                                }
+                                m_cv.notify_all();
+                            }
+
+    // number of keys currently pending
+    size_t                  size() const
+                            {
+                                std::lock_guard lock(m_mutex);
+                                return m_pendingCount;
+                            }
+
+    // -- counters since construction
+    uint64_t                pushedCount() const { return m_pushedCount.load(std::memory_order_relaxed); }
+    uint64_t                conflatedCount() const { return m_conflatedCount.load(std::memory_order_relaxed); }
+
+private:
+    // keeps the pending order intact, the order ring never needs more entries than there are slots
+    void                    grow(size_t minSize)
+                            {
+                                size_t newSize = std::max(minSize, m_slots.size() * 2);
+
+                                std::vector<size_t> order(newSize);
+                                for (size_t i = 0; i < m_pendingCount; ++i) {
+                                    order[i] = m_order[(m_head + i) % m_order.size()];
+                                }
+
+                                m_slots.resize(newSize);
+                                m_order = std::move(order);
+                                m_head = 0;
+                            }
+
+private:
+    std::vector<Slot>       m_slots;        // indexed by key
+    std::vector<size_t>     m_order;        // ring of pending keys
+    size_t                  m_head = 0;
+    size_t                  m_pendingCount = 0;
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cv;
+    bool                    m_shouldRun = true;
+    ShutdownMode            m_shutdownMode = ShutdownMode::Discard;
+
+    std::atomic<uint64_t>   m_pushedCount = 0;
+    std::atomic<uint64_t>   m_conflatedCount = 0;
+};
+
+} // namespace stockbot
+
+#endif
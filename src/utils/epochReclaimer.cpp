@@ -0,0 +1,89 @@
+#include "epochReclaimer.h"
+#include <algorithm>
+#include <limits>
+
+namespace stockbot {
+
+EpochReclaimer& EpochReclaimer::instance()
+{
+    static EpochReclaimer reclaimer;
+    return reclaimer;
+}
+
+EpochReclaimer::~EpochReclaimer()
+{
+    // nothing reads anymore at static destruction
+    for (const Retired& retired : m_retired) {
+        retired.destroy(retired.object);
+    }
+}
+
+void EpochReclaimer::enter()
+{
+    ThreadSlot& slot = local();
+    if (slot.depth++ == 0) {
+        slot.epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        // A seq_cst store only orders against other seq_cst operations, the acquire loads of the
+        // protected pointers could still be satisfied before it is visible to reclaim(). The
+        // fence keeps them after it: either reclaim() sees this epoch or we see the new pointer.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void EpochReclaimer::leave()
+{
+    ThreadSlot& slot = local();
+    if (--slot.depth == 0) {
+        slot.epoch.store(0, std::memory_order_release);
+    }
+}
+
+EpochReclaimer::ThreadSlot* EpochReclaimer::registerThread()
+{
+    std::lock_guard lock(m_mutex);
+    m_threads.push_back(std::make_unique<ThreadSlot>());
+    return m_threads.back().get();
+}
+
+void EpochReclaimer::retire(void* object, void (*destroy)(void*))
+{
+    {
+        std::lock_guard lock(m_mutex);
+        // Readers that entered at this epoch or before may hold the object. The ones entering
+        // after the increment load the pointer after it was swapped.
+        uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+        m_retired.push_back({ epoch, object, destroy });
+    }
+    reclaim();
+}
+
+size_t EpochReclaimer::reclaim()
+{
+    std::vector<Retired> ready;
+    size_t left;
+    {
+        std::lock_guard lock(m_mutex);
+
+        uint64_t oldestActive = std::numeric_limits<uint64_t>::max();
+        for (const auto& thread : m_threads) {
+            uint64_t epoch = thread->epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0) {
+                oldestActive = std::min(oldestActive, epoch);
+            }
+        }
+
+        auto stillHeld = std::partition(m_retired.begin(), m_retired.end(),
+                                        [oldestActive](const Retired& retired) { return retired.epoch >= oldestActive; });
+        ready.assign(stillHeld, m_retired.end());
+        m_retired.erase(stillHeld, m_retired.end());
+        left = m_retired.size();
+    }
+
+    // destructors run outside of the lock
+    for (const Retired& retired : ready) {
+        retired.destroy(retired.object);
+    }
+    return left;
+}
+
+} // namespace stockbot
@@ -0,0 +1,87 @@
+#ifndef __EPOCH_RECLAIMER_H__
+#define __EPOCH_RECLAIMER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stockbot {
+
+// Epoch based reclamation for structures published through atomic pointers.
+//
+// Readers wrap their accesses in an EpochGuard, which only stores the current epoch in a slot
+// owned by the thread: no lock, no shared write. A writer swaps the pointer, then retires the
+// old object; it is destroyed once every thread that might still hold it has left its guard.
+class EpochReclaimer
+{
+    struct alignas(64) ThreadSlot {
+        std::atomic<uint64_t>       epoch = 0;      // 0 while outside of any guard
+        unsigned                    depth = 0;      // nested guards, owner thread only
+    };
+
+    struct Retired {
+        uint64_t                    epoch;
+        void*                       object;
+        void                        (*destroy)(void*);
+    };
+
+public:
+    static EpochReclaimer&          instance();
+
+    // -- readers, see EpochGuard
+    void                            enter();
+    void                            leave();
+
+    // -- writers
+    // Call after the object can no longer be reached by new readers. Takes ownership.
+    template <typename T>
+    void                            retire(const T* object)
+                                    {
+                                        if (object) {
+                                            retire(const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); });
+                                        }
+                                    }
+
+    // destroys the retired objects no reader can hold anymore, returns how many are left
+    size_t                          reclaim();
+
+private:
+                                    EpochReclaimer() = default;
+                                    ~EpochReclaimer();
+
+    void                            retire(void* object, void (*destroy)(void*));
+
+    ThreadSlot&                     local()
+                                    {
+                                        thread_local ThreadSlot* slot = registerThread();
+                                        return *slot;
+                                    }
+
+    ThreadSlot*                     registerThread();
+
+private:
+    std::atomic<uint64_t>           m_epoch = 1;
+
+    std::mutex                      m_mutex;
+    // never shrinks, slots of finished threads stay at 0
+    std::vector<std::unique_ptr<ThreadSlot>>
+                                    m_threads;
+    std::vector<Retired>            m_retired;
+};
+
+// Read side critical section, pointers loaded inside stay valid until it ends. Nests.
+class EpochGuard
+{
+public:
+                                    EpochGuard() { EpochReclaimer::instance().enter(); }
+                                    ~EpochGuard() { EpochReclaimer::instance().leave(); }
+
+                                    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard&                     operator=(const EpochGuard&) = delete;
+};
+
+} // namespace stockbot
+
+#endif
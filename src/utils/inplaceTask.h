@@ -0,0 +1,106 @@
+#ifndef __INPLACE_TASK_H__
+#define __INPLACE_TASK_H__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stockbot {
+
+// Move only void() callable stored in an inline buffer of Capacity bytes, never allocates.
+//
+// A callable that doesn't fit is a compile error rather than a silent heap fallback: capture
+// less (a pointer, an id) or raise the capacity. Moving a task moves the callable, which must not
+// throw on move so the queues can shuffle tasks around freely.
+template <size_t Capacity>
+class InplaceTask
+{
+    struct VTable {
+        void                    (*invoke)(void* self);
+        void                    (*relocate)(void* dst, void* src);     // move constructs dst, destroys src
+        void                    (*destroy)(void* self);
+    };
+
+    template <typename F>
+    static constexpr VTable     VTABLE_OF = {
+                                    [](void* self) { (*static_cast<F*>(self))(); },
+                                    [](void* dst, void* src) {
+                                        ::new (dst) F(std::move(*static_cast<F*>(src)));
+                                        static_cast<F*>(src)->~F();
+                                    },
+                                    [](void* self) { static_cast<F*>(self)->~F(); },
+                                };
+
+public:
+    static constexpr size_t     CAPACITY = Capacity;
+
+                                InplaceTask() = default;
+                                InplaceTask(std::nullptr_t) {}
+
+    template <typename F>
+        requires (!std::is_same_v<std::remove_cvref_t<F>, InplaceTask> && std::is_invocable_r_v<void, std::decay_t<F>&>)
+                                InplaceTask(F&& f)
+                                {
+                                    using Fn = std::decay_t<F>;
+                                    static_assert(sizeof(Fn) <= Capacity, "the capture doesn't fit the inline buffer of the task");
+                                    static_assert(alignof(Fn) <= alignof(std::max_align_t), "over aligned capture");
+                                    static_assert(std::is_nothrow_move_constructible_v<Fn>, "the capture must be nothrow movable");
+                                    ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(f));
+                                    m_vtable = &VTABLE_OF<Fn>;
+                                }
+
+                                InplaceTask(InplaceTask&& other) noexcept
+                                {
+                                    moveFrom(other);
+                                }
+
+    InplaceTask&                operator=(InplaceTask&& other) noexcept
+                                {
+                                    if (this != &other) {
+                                        reset();
+                                        moveFrom(other);
+                                    }
+                                    return *this;
+                                }
+
+    InplaceTask&                operator=(std::nullptr_t) noexcept
+                                {
+                                    reset();
+                                    return *this;
+                                }
+
+                                InplaceTask(const InplaceTask&) = delete;
+    InplaceTask&                operator=(const InplaceTask&) = delete;
+
+                                ~InplaceTask() { reset(); }
+
+    void                        operator()() { m_vtable->invoke(m_storage); }
+
+    explicit                    operator bool() const { return m_vtable != nullptr; }
+
+private:
+    void                        moveFrom(InplaceTask& other) noexcept
+                                {
+                                    if (other.m_vtable) {
+                                        other.m_vtable->relocate(m_storage, other.m_storage);
+                                        m_vtable = std::exchange(other.m_vtable, nullptr);
+                                    }
+                                }
+
+    void                        reset() noexcept
+                                {
+                                    if (m_vtable) {
+                                        std::exchange(m_vtable, nullptr)->destroy(m_storage);
+                                    }
+                                }
+
+private:
+    alignas(std::max_align_t) std::byte
+                                m_storage[Capacity];
+    const VTable*               m_vtable = nullptr;
+};
+
+} // namespace stockbot
+
+#endif
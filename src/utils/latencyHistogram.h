@@ -0,0 +1,82 @@
+#ifndef __LATENCY_HISTOGRAM_H__
+#define __LATENCY_HISTOGRAM_H__
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace stockbot {
+
+// Log-linear (HDR style) histogram of nanosecond latencies.
+//
+// Every power of two range is split into SUB_BUCKET_COUNT linear buckets, so a recorded value
+// is off by at most 1/32 (~3%) whatever its magnitude. Values past 2^(MAX_EXPONENT + 1) ns
+// (~73 minutes) land in the last bucket.
+//
+// Single writer: record() is a plain load and store on relaxed atomics, no read-modify-write.
+// Any thread can read the counts at the same time.
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned       SUB_BUCKET_BITS = 5;
+    static constexpr size_t         SUB_BUCKET_COUNT = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr unsigned       MAX_EXPONENT = 41;
+    static constexpr size_t         BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+
+    using Counts = std::array<uint64_t, BUCKET_COUNT>;
+
+    static size_t                   bucketIndex(int64_t ns)
+                                    {
+                                        uint64_t value = ns > 0 ? uint64_t(ns) : 0;
+                                        if (value < SUB_BUCKET_COUNT) {
+                                            return value;
+                                        }
+
+                                        unsigned exponent = std::bit_width(value) - 1;
+                                        if (exponent > MAX_EXPONENT) {
+                                            return BUCKET_COUNT - 1;
+                                        }
+                                        size_t mantissa = value >> (exponent - SUB_BUCKET_BITS);
+                                        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + (mantissa - SUB_BUCKET_COUNT);
+                                    }
+
+    // largest value that falls into the bucket
+    static int64_t                  highestValue(size_t index)
+                                    {
+                                        if (index < SUB_BUCKET_COUNT) {
+                                            return int64_t(index);
+                                        }
+
+                                        unsigned exponent = unsigned(index / SUB_BUCKET_COUNT) + SUB_BUCKET_BITS - 1;
+                                        uint64_t mantissa = SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT;
+                                        uint64_t width = uint64_t(1) << (exponent - SUB_BUCKET_BITS);
+                                        return int64_t(mantissa * width + width - 1);
+                                    }
+
+    // -- writer
+    void                            record(int64_t ns)
+                                    {
+                                        std::atomic<uint64_t>& count = m_counts[bucketIndex(ns)];
+                                        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                                        m_sum.store(m_sum.load(std::memory_order_relaxed) + uint64_t(ns > 0 ? ns : 0), std::memory_order_relaxed);
+                                    }
+
+    // -- readers, adds to what is already in counts / sum
+    void                            addTo(Counts& counts, uint64_t& sum) const
+                                    {
+                                        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                                            counts[i] += m_counts[i].load(std::memory_order_relaxed);
+                                        }
+                                        sum += m_sum.load(std::memory_order_relaxed);
+                                    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT>
+                                    m_counts{};
+    std::atomic<uint64_t>           m_sum = 0;
+};
+
+} // namespace stockbot
+
+#endif
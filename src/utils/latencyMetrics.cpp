@@ -0,0 +1,105 @@
+#include "latencyMetrics.h"
+
+namespace stockbot {
+
+const char* toString(LatencyStage stage)
+{
+    switch (stage) {
+        case LatencyStage::StreamHandler:       return "stream_handler";
+        case LatencyStage::StreamQueueWait:     return "stream_queue_wait";
+        case LatencyStage::Decode:              return "decode";
+        case LatencyStage::PartitionQueueWait:  return "partition_queue_wait";
+        case LatencyStage::BufferUpdate:        return "buffer_update";
+        case LatencyStage::CriticalTaskWait:    return "task_wait_critical";
+        case LatencyStage::NormalTaskWait:      return "task_wait_normal";
+        case LatencyStage::BackgroundTaskWait:  return "task_wait_background";
+        case LatencyStage::TaskRun:             return "task_run";
+        case LatencyStage::TickToTask:          return "tick_to_task";
+        case LatencyStage::TickToDecision:      return "tick_to_decision";
+        case LatencyStage::TimerLate:           return "timer_late";
+        case LatencyStage::Count:               break;
+    }
+
+    return "unknown";
+}
+
+LatencyMetrics& LatencyMetrics::instance()
+{
+    static LatencyMetrics metrics;
+    return metrics;
+}
+
+LatencyMetrics::ThreadHistograms* LatencyMetrics::registerThread()
+{
+    std::lock_guard lock(m_mutex);
+    m_threads.push_back(std::make_unique<ThreadHistograms>());
+    return m_threads.back().get();
+}
+
+void LatencyMetrics::totals(LatencyStage stage, LatencyHistogram::Counts& counts, uint64_t& sum)
+{
+    std::lock_guard lock(m_mutex);
+    for (const auto& thread : m_threads) {
+        thread->stages[size_t(stage)].addTo(counts, sum);
+    }
+}
+
+LatencySummary LatencyMetrics::summary(LatencyStage stage, bool reset)
+{
+    size_t index = static_cast<size_t>(stage);
+
+    // the histograms are only ever added to, the interval is the difference to the baseline
+    Snapshot total;
+    std::lock_guard lock(m_mutex);
+    for (const auto& thread : m_threads) {
+        thread->stages[index].addTo(total.counts, total.sum);
+    }
+
+    Snapshot& baseline = m_baselines[index];
+    LatencyHistogram::Counts counts;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] = total.counts[i] - baseline.counts[i];
+    }
+    LatencySummary result = summarize(counts, total.sum - baseline.sum);
+
+    if (reset) {
+        baseline = total;
+    }
+
+    return result;
+}
+
+LatencySummary summarize(const LatencyHistogram::Counts& counts, uint64_t sum)
+{
+    LatencySummary result;
+    for (uint64_t count : counts) {
+        result.count += count;
+    }
+    if (result.count == 0) {
+        return result;
+    }
+
+    result.mean = double(sum) / result.count;
+
+    // highest value of the bucket holding the p-th sample
+    auto percentile = [&](double p) {
+        uint64_t target = std::max<uint64_t>(1, uint64_t(p * result.count + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return LatencyHistogram::highestValue(i);
+            }
+        }
+        return LatencyHistogram::highestValue(counts.size() - 1);
+    };
+    result.p50 = percentile(0.5);
+    result.p90 = percentile(0.9);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    result.max = percentile(1.0);
+
+    return result;
+}
+
+} // namespace stockbot
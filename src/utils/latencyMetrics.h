@@ -0,0 +1,98 @@
+#ifndef __LATENCY_METRICS_H__
+#define __LATENCY_METRICS_H__
+
+#include "utils/latencyHistogram.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stockbot {
+
+// where a tick spends its time, in pipeline order
+enum class LatencyStage : char {
+    StreamHandler,          // streamer callback entry to the frame being queued
+    StreamQueueWait,        // waiting in the stream data queue
+    Decode,                 // decoding (and routing) one frame
+    PartitionQueueWait,     // partitioned ingest, waiting in the partition queue
+    BufferUpdate,           // applying an update to the StreamDataBuffer
+    CriticalTaskWait,       // waiting in the task manager, one stage per TaskPriority lane
+    NormalTaskWait,
+    BackgroundTaskWait,
+    TaskRun,                // task execution
+    TickToTask,             // streamer callback entry to the start of the task it scheduled
+    TickToDecision,         // streamer callback entry to the rules of the symbol evaluated on it
+    TimerLate,              // due time of a scheduled task to it being queued
+
+    Count,
+};
+
+const char* toString(LatencyStage stage);
+
+struct LatencySummary {
+    uint64_t                        count = 0;
+    double                          mean = 0.0;     // -- all in ns
+    int64_t                         p50 = 0;
+    int64_t                         p90 = 0;
+    int64_t                         p99 = 0;
+    int64_t                         p999 = 0;
+    int64_t                         max = 0;
+};
+
+// count, mean and percentiles of histogram counts, the percentiles are the highest value of their
+// bucket (within ~3%)
+LatencySummary                      summarize(const LatencyHistogram::Counts& counts, uint64_t sum);
+
+// Process wide per stage latency histograms.
+//
+// Every thread records into its own set of histograms, registered the first time it records,
+// so the hot path never shares a cache line with another thread. Readers merge the per thread
+// histograms on demand.
+class LatencyMetrics
+{
+    struct ThreadHistograms {
+        std::array<LatencyHistogram, size_t(LatencyStage::Count)>
+                                    stages;
+    };
+
+    struct Snapshot {
+        LatencyHistogram::Counts    counts{};
+        uint64_t                    sum = 0;
+    };
+
+public:
+    static LatencyMetrics&          instance();
+
+    void                            record(LatencyStage stage, int64_t ns) { local().stages[size_t(stage)].record(ns); }
+
+    // Everything recorded since the last reset. Resetting starts a new interval for all the
+    // readers, the counts themselves are never cleared so the writers stay lock free.
+    LatencySummary                  summary(LatencyStage stage, bool reset = true);
+
+    // Everything recorded since the start of the process, added to counts / sum. Not affected by
+    // summary() resets, for exporters that want monotonic counts.
+    void                            totals(LatencyStage stage, LatencyHistogram::Counts& counts, uint64_t& sum);
+
+private:
+                                    LatencyMetrics() = default;
+
+    ThreadHistograms&               local()
+                                    {
+                                        thread_local ThreadHistograms* histograms = registerThread();
+                                        return *histograms;
+                                    }
+
+    ThreadHistograms*               registerThread();
+
+private:
+    std::mutex                      m_mutex;
+    // never shrinks, the histograms of finished threads are still part of the totals
+    std::vector<std::unique_ptr<ThreadHistograms>>
+                                    m_threads;
+    std::array<Snapshot, size_t(LatencyStage::Count)>
+                                    m_baselines;    // totals at the last reset
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef __PARKER_H__
+#define __PARKER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace stockbot {
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Spin-then-park wait strategy for the lock free queues.
+//
+// Waiters spin on the condition for a short while and only then park on a condition variable.
+// Notifiers skip the mutex entirely unless someone is parked, so the uncontended path is a fence
+// and a load.
+class Parker
+{
+public:
+    static constexpr int        SPIN_COUNT = 256;
+
+    // returns once ready() returns true, ready() may be called many times
+    template <typename Pred>
+    void                        wait(Pred ready)
+                                {
+                                    for (int i = 0; i < SPIN_COUNT; ++i) {
+                                        if (ready()) return;
+                                        cpuRelax();
+                                    }
+
+                                    std::unique_lock lock(m_mutex);
+                                    m_waiters.fetch_add(1, std::memory_order_relaxed);
+                                    // pairs with the fence in notifyOne(), either we see the new state or they see us
+                                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                                    while (!ready()) {
+                                        m_cv.wait(lock);
+                                    }
+                                    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+                                }
+
+    // same as wait() but gives up after the timeout, returns the last result of ready()
+    template <typename Pred, typename Rep, typename Period>
+    bool                        waitFor(Pred ready, const std::chrono::duration<Rep, Period>& timeout)
+                                {
+                                    for (int i = 0; i < SPIN_COUNT; ++i) {
+                                        if (ready()) return true;
+                                        cpuRelax();
+                                    }
+
+                                    std::unique_lock lock(m_mutex);
+                                    m_waiters.fetch_add(1, std::memory_order_relaxed);
+                                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                                    bool result = m_cv.wait_for(lock, timeout, ready);
+                                    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+                                    return result;
+                                }
+
+    // call after publishing the state change ready() is waiting for
+    void                        notifyOne()
+                                {
+                                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                                    if (m_waiters.load(std::memory_order_relaxed) > 0) {
+                                        std::lock_guard lock(m_mutex);
+                                        m_cv.notify_one();
+                                    }
+                                }
+
+    void                        notifyAll()
+                                {
+                                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                                    if (m_waiters.load(std::memory_order_relaxed) > 0) {
+                                        std::lock_guard lock(m_mutex);
+                                        m_cv.notify_all();
+                                    }
+                                }
+
+private:
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cv;
+    std::atomic<int>            m_waiters = 0;
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,399 @@
+#ifndef __RING_QUEUE_H__
+#define __RING_QUEUE_H__
+
+#include "utils/concurrentQueue.h"
+#include "utils/parker.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace stockbot {
+
+enum class QueueMode : char {
+    MPMC,
+    SPSC,   // exactly one producer thread and one consumer thread
+};
+
+// what push() does when the ring is full
+enum class OverflowPolicy : char {
+    Block,      // wait for space
+    DropOldest, // discard the oldest item to make room (MPMC only)
+    Reject,     // push() returns false
+};
+
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Lock free storage of the ring, non blocking only. Capacity is a power of two.
+template <typename T, QueueMode Mode>
+class RingStorage;
+
+// multi producer / multi consumer, the per cell sequence tells producers and consumers whose turn it is (Vyukov)
+template <typename T>
+class RingStorage<T, QueueMode::MPMC>
+{
+    struct Cell {
+        std::atomic<size_t>     seq;
+        T                       data;
+    };
+
+public:
+    explicit                    RingStorage(size_t capacity)
+                                    : m_capacity(capacity)
+                                    , m_mask(capacity - 1)
+                                    , m_cells(std::make_unique<Cell[]>(capacity))
+                                {
+                                    for (size_t i = 0; i < m_capacity; ++i) {
+                                        m_cells[i].seq.store(i, std::memory_order_relaxed);
+                                    }
+                                }
+
+    template <typename U>
+    bool                        tryPush(U&& data)
+                                {
+                                    size_t pos = m_tail.load(std::memory_order_relaxed);
+                                    Cell* cell;
+                                    while (true) {
+                                        cell = &m_cells[pos & m_mask];
+                                        size_t seq = cell->seq.load(std::memory_order_acquire);
+                                        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                                        if (diff == 0) {
+                                            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                                        } else if (diff < 0) {
+                                            return false;  // full
+                                        } else {
+                                            pos = m_tail.load(std::memory_order_relaxed);
+                                        }
+                                    }
+
+                                    cell->data = std::forward<U>(data);
+                                    cell->seq.store(pos + 1, std::memory_order_release);
+                                    return true;
+                                }
+
+    bool                        tryPop(T& data)
+                                {
+                                    size_t pos = m_head.load(std::memory_order_relaxed);
+                                    Cell* cell;
+                                    while (true) {
+                                        cell = &m_cells[pos & m_mask];
+                                        size_t seq = cell->seq.load(std::memory_order_acquire);
+                                        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                                        if (diff == 0) {
+                                            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                                        } else if (diff < 0) {
+                                            return false;  // empty
+                                        } else {
+                                            pos = m_head.load(std::memory_order_relaxed);
+                                        }
+                                    }
+
+                                    data = std::move(cell->data);
+                                    cell->seq.store(pos + m_capacity, std::memory_order_release);
+                                    return true;
+                                }
+
+    // approximate when used concurrently
+    size_t                      size() const
+                                {
+                                    size_t tail = m_tail.load(std::memory_order_relaxed);
+                                    size_t head = m_head.load(std::memory_order_relaxed);
+                                    return tail > head ? tail - head : 0;
+                                }
+
+private:
+    const size_t                m_capacity;
+    const size_t                m_mask;
+    std::unique_ptr<Cell[]>     m_cells;
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t>         m_head = 0;
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t>         m_tail = 0;
+};
+
+// single producer / single consumer, each side owns its index and keeps a cached copy of the
+// other one, so the common case touches no shared cache line besides the slot itself
+template <typename T>
+class RingStorage<T, QueueMode::SPSC>
+{
+public:
+    explicit                    RingStorage(size_t capacity)
+                                    : m_capacity(capacity)
+                                    , m_mask(capacity - 1)
+                                    , m_slots(std::make_unique<T[]>(capacity))
+                                {
+                                }
+
+    // -- producer side
+    template <typename U>
+    bool                        tryPush(U&& data)
+                                {
+                                    size_t tail = m_tail.load(std::memory_order_relaxed);
+                                    if (tail - m_cachedHead == m_capacity) {
+                                        m_cachedHead = m_head.load(std::memory_order_acquire);
+                                        if (tail - m_cachedHead == m_capacity) return false;  // full
+                                    }
+
+                                    m_slots[tail & m_mask] = std::forward<U>(data);
+                                    m_tail.store(tail + 1, std::memory_order_release);
+                                    return true;
+                                }
+
+    // -- consumer side
+    bool                        tryPop(T& data)
+                                {
+                                    size_t head = m_head.load(std::memory_order_relaxed);
+                                    if (head == m_cachedTail) {
+                                        m_cachedTail = m_tail.load(std::memory_order_acquire);
+                                        if (head == m_cachedTail) return false;  // empty
+                                    }
+
+                                    data = std::move(m_slots[head & m_mask]);
+                                    m_head.store(head + 1, std::memory_order_release);
+                                    return true;
+                                }
+
+    // approximate when used concurrently
+    size_t                      size() const
+                                {
+                                    size_t tail = m_tail.load(std::memory_order_relaxed);
+                                    size_t head = m_head.load(std::memory_order_relaxed);
+                                    return tail > head ? tail - head : 0;
+                                }
+
+private:
+    const size_t                m_capacity;
+    const size_t                m_mask;
+    std::unique_ptr<T[]>        m_slots;
+
+    // -- consumer side
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t>         m_head = 0;
+    size_t                      m_cachedTail = 0;
+
+    // -- producer side
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t>         m_tail = 0;
+    size_t                      m_cachedHead = 0;
+};
+
+// Bounded lock free ring with the ConcurrentQueue interface.
+//
+// Capacity is rounded up to a power of two. Waiting (pop on empty, blocking push on full) spins
+// briefly and then parks. DropOldest needs the producer to consume and is not available with
+// QueueMode::SPSC.
+template <typename T, QueueMode Mode = QueueMode::MPMC>
+class RingQueue
+{
+public:
+    explicit                    RingQueue(size_t capacity, OverflowPolicy policy = OverflowPolicy::Block)
+                                    : m_ring(std::bit_ceil(std::max<size_t>(capacity, 2)))
+                                    , m_capacity(std::bit_ceil(std::max<size_t>(capacity, 2)))
+                                    , m_policy(policy)
+                                {
+                                    assert((Mode == QueueMode::MPMC || policy != OverflowPolicy::DropOldest) &&
+                                           "DropOldest is not supported by the SPSC ring");
+                                }
+
+    // false if rejected or shut down
+    template <typename U = T>
+    bool                        push(U&& data)
+                                {
+                                    beginPush();
+                                    bool result = pushOne(std::forward<U>(data));
+                                    endPush(result, false);
+                                    return result;
+                                }
+
+    template <typename... Args>
+    bool                        emplace(Args&&... args)
+                                {
+                                    return push(T(std::forward<Args>(args)...));
+                                }
+
+    // pass move iterators to avoid the copies, returns the number of items pushed
+    template <typename InputIt>
+    size_t                      pushBulk(InputIt first, InputIt last)
+                                {
+                                    beginPush();
+                                    size_t count = 0;
+                                    for (; first != last && pushOne(*first); ++first) {
+                                        ++count;
+                                    }
+                                    endPush(count > 0, true);
+                                    return count;
+                                }
+
+    bool                        pop(T& data)
+                                {
+                                    bool result = false;
+                                    m_notEmpty.wait([&] { return tryPopOrStop(data, result); });
+
+                                    onPopped(result);
+                                    return result;
+                                }
+
+    // false if nothing arrived within the timeout
+    template <typename Rep, typename Period>
+    bool                        popFor(T& data, const std::chrono::duration<Rep, Period>& timeout)
+                                {
+                                    bool result = false;
+                                    m_notEmpty.waitFor([&] { return tryPopOrStop(data, result); }, timeout);
+
+                                    onPopped(result);
+                                    return result;
+                                }
+
+    // never blocks, respects shutdown like pop()
+    bool                        tryPop(T& data)
+                                {
+                                    bool result = false;
+                                    tryPopOrStop(data, result);
+
+                                    onPopped(result);
+                                    return result;
+                                }
+
+    // Blocks until there is something to pop, then moves up to maxCount items to out.
+    // Returns the number of items popped, 0 means the queue was shut down.
+    template <typename OutputIt>
+    size_t                      popBulk(OutputIt out, size_t maxCount)
+                                {
+                                    T data;
+                                    if (maxCount == 0 || !pop(data)) return 0;
+
+                                    *out++ = std::move(data);
+                                    size_t count = 1;
+                                    while (count < maxCount && tryPop(data)) {
+                                        *out++ = std::move(data);
+                                        ++count;
+                                    }
+                                    return count;
+                                }
+
+    void                        shutdown(ShutdownMode mode = ShutdownMode::Discard)
+                                {
+                                    m_shutdownMode.store(mode, std::memory_order_relaxed);
+                                    // seq_cst against beginPush()
+                                    m_shouldRun.store(false);
+                                    m_notEmpty.notifyAll();
+                                    m_notFull.notifyAll();
+                                }
+
+    // approximate when used concurrently
+    size_t                      size() const { return m_ring.size(); }
+    size_t                      capacity() const { return m_capacity; }
+
+    uint64_t                    droppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+    uint64_t                    rejectedCount() const { return m_rejectedCount.load(std::memory_order_relaxed); }
+
+private:
+    // A push that got past the m_shouldRun check lands after shutdown() returned, draining
+    // consumers wait for the pushes in flight before they call the queue empty.
+    void                        beginPush() { m_pushesInFlight.fetch_add(1); }
+
+    void                        endPush(bool pushed, bool wakeAll)
+                                {
+                                    m_pushesInFlight.fetch_sub(1, std::memory_order_release);
+                                    if (!m_shouldRun.load(std::memory_order_acquire)) {
+                                        // the draining consumers are waiting on the count, not on an item
+                                        m_notEmpty.notifyAll();
+                                    } else if (pushed) {
+                                        wakeAll ? m_notEmpty.notifyAll() : m_notEmpty.notifyOne();
+                                    }
+                                }
+
+    // between beginPush() and endPush()
+    template <typename U>
+    bool                        pushOne(U&& data)
+                                {
+                                    if (!m_shouldRun.load()) return false;
+
+                                    bool result = m_ring.tryPush(std::forward<U>(data));
+                                    if (!result) {
+                                        switch (m_policy) {
+                                            case OverflowPolicy::Block:
+                                            {
+                                                m_notFull.wait([&] {
+                                                    if (!m_shouldRun.load(std::memory_order_acquire)) return true;
+                                                    result = m_ring.tryPush(std::forward<U>(data));
+                                                    return result;
+                                                });
+                                                break;
+                                            }
+                                            case OverflowPolicy::DropOldest:
+                                            {
+                                                if constexpr (Mode == QueueMode::MPMC) {
+                                                    while (!result) {
+                                                        T dropped;
+                                                        if (m_ring.tryPop(dropped)) {
+                                                            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                                                        }
+                                                        result = m_ring.tryPush(std::forward<U>(data));
+                                                    }
+                                                }
+                                                break;
+                                            }
+                                            case OverflowPolicy::Reject:
+                                            {
+                                                m_rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                                                break;
+                                            }
+                                        }
+                                    }
+
+                                    return result;
+                                }
+
+    // the wait predicate of the pops, true when the caller should stop waiting
+    bool                        tryPopOrStop(T& data, bool& result)
+                                {
+                                    if (m_shouldRun.load(std::memory_order_acquire)) {
+                                        result = m_ring.tryPop(data);
+                                        return result;
+                                    }
+
+                                    // discarding all objects when signaled to exit, unless draining
+                                    if (m_shutdownMode.load(std::memory_order_relaxed) == ShutdownMode::Drain) {
+                                        result = m_ring.tryPop(data);
+                                        if (!result) {
+                                            // empty for good only once no push is still landing, seq_cst against beginPush()
+                                            if (m_pushesInFlight.load() > 0) return false;
+                                            result = m_ring.tryPop(data);
+                                        }
+                                    }
+                                    return true;
+                                }
+
+    void                        onPopped(bool result)
+                                {
+                                    if (result && m_policy == OverflowPolicy::Block) {
+                                        m_notFull.notifyOne();
+                                    }
+                                }
+
+private:
+    RingStorage<T, Mode>        m_ring;
+    const size_t                m_capacity;
+    const OverflowPolicy        m_policy;
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<bool>           m_shouldRun = true;
+    std::atomic<ShutdownMode>   m_shutdownMode = ShutdownMode::Discard;
+    std::atomic<uint64_t>       m_droppedCount = 0;
+    std::atomic<uint64_t>       m_rejectedCount = 0;
+    // written by every push, kept off the line the consumers read m_shouldRun from
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t>         m_pushesInFlight = 0;
+    Parker                      m_notEmpty;
+    Parker                      m_notFull;
+};
+
+} // namespace stockbot
+
+#endif
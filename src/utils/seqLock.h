@@ -0,0 +1,74 @@
+#ifndef __SEQ_LOCK_H__
+#define __SEQ_LOCK_H__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace stockbot {
+
+// Single writer / multi reader sequence lock around a trivially copyable value.
+//
+// Readers never block, they retry if a write overlapped with their copy. The value is kept in
+// atomic words so the concurrent copy is not a data race. Writers must be serialized by the
+// caller.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable type");
+
+    static constexpr size_t         WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    using Words = std::array<uint64_t, WORD_COUNT>;
+
+public:
+                                    SeqLock() : SeqLock(T{}) {}
+    explicit                        SeqLock(const T& value) { store(value); }
+
+    void                            store(const T& value)
+                                    {
+                                        Words words{};
+                                        std::memcpy(words.data(), static_cast<const void*>(&value), sizeof(T));
+
+                                        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+                                        // odd: write in progress
+                                        m_seq.store(seq + 1, std::memory_order_relaxed);
+                                        std::atomic_thread_fence(std::memory_order_release);
+
+                                        for (size_t i = 0; i < WORD_COUNT; ++i) {
+                                            m_words[i].store(words[i], std::memory_order_relaxed);
+                                        }
+
+                                        m_seq.store(seq + 2, std::memory_order_release);
+                                    }
+
+    T                               load() const
+                                    {
+                                        Words words;
+                                        uint64_t before;
+                                        uint64_t after;
+                                        do {
+                                            before = m_seq.load(std::memory_order_acquire);
+                                            for (size_t i = 0; i < WORD_COUNT; ++i) {
+                                                words[i] = m_words[i].load(std::memory_order_relaxed);
+                                            }
+                                            std::atomic_thread_fence(std::memory_order_acquire);
+                                            after = m_seq.load(std::memory_order_relaxed);
+                                        } while ((before & 1) || before != after);
+
+                                        // trivially copyable, a default member initializer doesn't make the copy unsafe
+                                        T value;
+                                        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+                                        return value;
+                                    }
+
+private:
+    std::atomic<uint64_t>           m_seq = 0;
+    std::array<std::atomic<uint64_t>, WORD_COUNT>
+                                    m_words;
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,64 @@
+#include "symbolTable.h"
+#include <mutex>
+
+namespace stockbot {
+
+SymbolTable& SymbolTable::instance()
+{
+    static SymbolTable table;
+    return table;
+}
+
+SymbolTable::SymbolTable()
+    : m_names(std::make_unique<std::string[]>(MAX_SYMBOLS))
+    , m_slots(std::make_unique<std::atomic<SymbolId>[]>(SLOT_COUNT))
+    , m_size(0)
+{
+    for (size_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        m_slots[slot].store(INVALID_SYMBOL, std::memory_order_relaxed);
+    }
+}
+
+SymbolId SymbolTable::intern(std::string_view ticker)
+{
+    if (SymbolId id = find(ticker); id != INVALID_SYMBOL) {
+        return id;
+    }
+
+    std::lock_guard lock(m_mutex);
+
+    // could have been interned while we were waiting for the lock, the free slot it stops at is ours
+    size_t slot = slotOf(ticker);
+    for (SymbolId id; (id = m_slots[slot].load(std::memory_order_relaxed)) != INVALID_SYMBOL; slot = (slot + 1) & (SLOT_COUNT - 1)) {
+        if (m_names[id] == ticker) {
+            return id;
+        }
+    }
+
+    size_t size = m_size.load(std::memory_order_relaxed);
+    if (size >= MAX_SYMBOLS) {
+        return INVALID_SYMBOL;
+    }
+
+    SymbolId id = static_cast<SymbolId>(size);
+    m_names[id] = std::string(ticker);
+
+    // publish the name
+    m_slots[slot].store(id, std::memory_order_release);
+    m_size.store(size + 1, std::memory_order_release);
+
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view ticker) const
+{
+    // at most half full, a free slot always ends the probe
+    for (size_t slot = slotOf(ticker);; slot = (slot + 1) & (SLOT_COUNT - 1)) {
+        SymbolId id = m_slots[slot].load(std::memory_order_acquire);
+        if (id == INVALID_SYMBOL || m_names[id] == ticker) {
+            return id;
+        }
+    }
+}
+
+}
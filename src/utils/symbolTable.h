@@ -0,0 +1,67 @@
+#ifndef __SYMBOL_TABLE_H__
+#define __SYMBOL_TABLE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace stockbot {
+
+// dense id of an interned ticker, usable as an array index
+using SymbolId = uint32_t;
+
+static constexpr SymbolId INVALID_SYMBOL = std::numeric_limits<SymbolId>::max();
+
+// Process wide ticker interning.
+//
+// Tickers are interned once when they are registered/subscribed, everything downstream
+// passes the SymbolId around and only resolves the name for logging and discord output.
+//
+// Lookups are lock free, they run on every tick: an open addressing table of ids sized for
+// MAX_SYMBOLS at half load. Slots are only ever filled, the writer stores the name before it
+// publishes the id, a reader that sees the id sees the name.
+class SymbolTable
+{
+    static constexpr size_t         SLOT_COUNT = 16384;     // power of two, >= 2 * MAX_SYMBOLS
+
+public:
+    // ids are always below this, size the per symbol arrays with it
+    static constexpr SymbolId       MAX_SYMBOLS = 8192;
+
+    static SymbolTable&             instance();
+
+    // returns the existing id if already interned, INVALID_SYMBOL if the table is full
+    SymbolId                        intern(std::string_view ticker);
+
+    // lookup only, lock free, INVALID_SYMBOL if the ticker was never interned
+    SymbolId                        find(std::string_view ticker) const;
+
+    // lock free, id must come from this table
+    const std::string&              name(SymbolId id) const { return m_names[id]; }
+
+    size_t                          size() const { return m_size.load(std::memory_order_acquire); }
+
+private:
+                                    SymbolTable();
+
+    static size_t                   slotOf(std::string_view ticker) { return std::hash<std::string_view>{}(ticker) & (SLOT_COUNT - 1); }
+
+private:
+    static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0 && SLOT_COUNT >= 2 * MAX_SYMBOLS);
+
+    std::mutex                      m_mutex;                // writers only
+
+    // fixed storage so names can be read without the lock while new ones are interned
+    std::unique_ptr<std::string[]>  m_names;
+    std::unique_ptr<std::atomic<SymbolId>[]>
+                                    m_slots;                // INVALID_SYMBOL while free
+    std::atomic<size_t>             m_size;
+};
+
+} // namespace stockbot
+
+#endif
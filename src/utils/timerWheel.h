@@ -0,0 +1,246 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace stockbot {
+
+// Hierarchical hashed timer wheel, O(1) schedule and cancel.
+//
+// Time is cut into ticks of TICK_NS. Level 0 has a slot per tick for the next 64 ticks, every
+// level above has slots 64 times as wide, LEVEL_COUNT levels reach ~14 years. A timer sits in
+// the lowest level its due tick fits in and moves down a level each time the wheel reaches the
+// start of its slot, so it is touched at most LEVEL_COUNT times. Slots are absolute: slot
+// (tick >> 6L) & 63 of level L, and a bitmap per level finds the next busy slot without walking
+// the empty ones, so advance() jumps straight over idle time.
+//
+// A timer fires once its whole tick is over: never early, at most TICK_NS late.
+//
+// Not thread safe, the owner serializes the calls. Times are monotonicNowNs().
+template <typename Payload>
+class TimerWheel
+{
+    static constexpr unsigned   SLOT_BITS = 6;
+    static constexpr size_t     SLOT_COUNT = size_t(1) << SLOT_BITS;
+    static constexpr unsigned   LEVEL_COUNT = 7;
+    static constexpr uint32_t   NIL = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        int64_t                 dueNs = 0;
+        Payload                 payload{};
+        uint32_t                prev = NIL;
+        uint32_t                next = NIL;             // free list link while unused
+        uint32_t                slot = NIL;             // level * SLOT_COUNT + slot index
+        uint32_t                generation = 1;         // bumped on release, stale ids don't match
+    };
+
+public:
+    // 0 is never a valid id
+    using TimerId = uint64_t;
+
+    static constexpr int64_t    TICK_NS = 100'000;
+    static constexpr int64_t    NEVER = std::numeric_limits<int64_t>::max();
+
+    explicit                    TimerWheel(int64_t nowNs)
+                                    : m_currentTick(tickOf(nowNs))
+                                {
+                                    m_heads.fill(NIL);
+                                }
+
+    TimerId                     schedule(int64_t dueNs, Payload payload)
+                                {
+                                    uint32_t index = allocate();
+                                    Node& node = m_nodes[index];
+                                    node.dueNs = dueNs;
+                                    node.payload = std::move(payload);
+                                    link(index);
+                                    ++m_size;
+                                    return (TimerId(node.generation) << 32) | index;
+                                }
+
+    // false if the timer already fired or was cancelled
+    bool                        cancel(TimerId id)
+                                {
+                                    uint32_t index = uint32_t(id);
+                                    if (index >= m_nodes.size() || m_nodes[index].generation != uint32_t(id >> 32) || m_nodes[index].slot == NIL) {
+                                        return false;
+                                    }
+                                    unlink(index);
+                                    release(index);
+                                    --m_size;
+                                    return true;
+                                }
+
+    // when advance() has something to do next, NEVER when empty
+    int64_t                     nextEventNs() const
+                                {
+                                    int64_t tick = nextEventTick();
+                                    return tick == NEVER ? NEVER : (tick + 1) * TICK_NS;
+                                }
+
+    // Fires every timer due by nowNs, appending its payload to fired. Returns the number fired.
+    size_t                      advance(int64_t nowNs, std::vector<Payload>& fired)
+                                {
+                                    // the last tick that is entirely over
+                                    int64_t limit = tickOf(nowNs) - 1;
+                                    size_t count = 0;
+                                    for (int64_t tick = nextEventTick(); tick != NEVER && tick <= limit; tick = nextEventTick()) {
+                                        m_currentTick = tick;
+
+                                        // the timers of the slots starting here move down, the higher levels first
+                                        for (unsigned level = LEVEL_COUNT - 1; level > 0; --level) {
+                                            if ((tick & ((int64_t(1) << (SLOT_BITS * level)) - 1)) == 0) {
+                                                cascade(level, slotOf(tick, level));
+                                            }
+                                        }
+
+                                        uint32_t slot = slotOf(tick, 0);
+                                        uint32_t index = m_heads[slot];
+                                        m_heads[slot] = NIL;
+                                        m_occupied[0] &= ~(uint64_t(1) << slot);
+                                        while (index != NIL) {
+                                            Node& node = m_nodes[index];
+                                            uint32_t next = node.next;
+                                            fired.push_back(std::move(node.payload));
+                                            release(index);
+                                            --m_size;
+                                            ++count;
+                                            index = next;
+                                        }
+                                        m_currentTick = tick + 1;
+                                    }
+
+                                    // nothing in between, keeps the levels of new timers low
+                                    if (m_currentTick <= limit) {
+                                        m_currentTick = limit + 1;
+                                    }
+                                    return count;
+                                }
+
+    size_t                      size() const { return m_size; }
+
+private:
+    static int64_t              tickOf(int64_t ns) { return ns / TICK_NS; }
+    static uint32_t             slotOf(int64_t tick, unsigned level) { return uint32_t((tick >> (SLOT_BITS * level)) & (SLOT_COUNT - 1)); }
+
+    // the first tick, from m_currentTick on, where a busy slot fires or cascades
+    int64_t                     nextEventTick() const
+                                {
+                                    int64_t best = NEVER;
+                                    for (unsigned level = 0; level < LEVEL_COUNT; ++level) {
+                                        uint64_t occupied = m_occupied[level];
+                                        if (!occupied) {
+                                            continue;
+                                        }
+                                        // slots are at most SLOT_COUNT - 1 units ahead of the current one
+                                        unsigned shift = SLOT_BITS * level;
+                                        int64_t unit = m_currentTick >> shift;
+                                        unsigned distance = std::countr_zero(std::rotr(occupied, int(slotOf(m_currentTick, level))));
+                                        int64_t tick = (unit + distance) << shift;
+                                        if (tick < best) {
+                                            best = tick;
+                                        }
+                                    }
+                                    return best;
+                                }
+
+    // into the lowest level that reaches its due tick, relative to m_currentTick
+    void                        link(uint32_t index)
+                                {
+                                    Node& node = m_nodes[index];
+                                    // overdue fires with the current tick
+                                    int64_t due = std::max(tickOf(node.dueNs), m_currentTick);
+
+                                    unsigned level = 0;
+                                    while (level < LEVEL_COUNT - 1 && (due >> (SLOT_BITS * level)) - (m_currentTick >> (SLOT_BITS * level)) >= int64_t(SLOT_COUNT)) {
+                                        ++level;
+                                    }
+                                    unsigned shift = SLOT_BITS * level;
+                                    if ((due >> shift) - (m_currentTick >> shift) >= int64_t(SLOT_COUNT)) {
+                                        // past the reach of the top level, parked in its furthest slot until it gets closer
+                                        due = ((m_currentTick >> shift) + SLOT_COUNT - 1) << shift;
+                                    }
+
+                                    uint32_t slot = slotOf(due, level);
+                                    uint32_t& head = m_heads[level * SLOT_COUNT + slot];
+                                    node.slot = level * SLOT_COUNT + slot;
+                                    node.prev = NIL;
+                                    node.next = head;
+                                    if (head != NIL) {
+                                        m_nodes[head].prev = index;
+                                    }
+                                    head = index;
+                                    m_occupied[level] |= uint64_t(1) << slot;
+                                }
+
+    void                        unlink(uint32_t index)
+                                {
+                                    Node& node = m_nodes[index];
+                                    if (node.prev != NIL) {
+                                        m_nodes[node.prev].next = node.next;
+                                    } else {
+                                        m_heads[node.slot] = node.next;
+                                    }
+                                    if (node.next != NIL) {
+                                        m_nodes[node.next].prev = node.prev;
+                                    }
+                                    if (m_heads[node.slot] == NIL) {
+                                        m_occupied[node.slot / SLOT_COUNT] &= ~(uint64_t(1) << (node.slot % SLOT_COUNT));
+                                    }
+                                    node.slot = NIL;
+                                }
+
+    void                        cascade(unsigned level, uint32_t slot)
+                                {
+                                    uint32_t index = m_heads[level * SLOT_COUNT + slot];
+                                    m_heads[level * SLOT_COUNT + slot] = NIL;
+                                    m_occupied[level] &= ~(uint64_t(1) << slot);
+                                    while (index != NIL) {
+                                        uint32_t next = m_nodes[index].next;
+                                        link(index);
+                                        index = next;
+                                    }
+                                }
+
+    uint32_t                    allocate()
+                                {
+                                    if (m_free != NIL) {
+                                        uint32_t index = m_free;
+                                        m_free = m_nodes[index].next;
+                                        return index;
+                                    }
+                                    m_nodes.emplace_back();
+                                    return uint32_t(m_nodes.size() - 1);
+                                }
+
+    void                        release(uint32_t index)
+                                {
+                                    Node& node = m_nodes[index];
+                                    node.payload = Payload{};
+                                    node.slot = NIL;
+                                    node.prev = NIL;
+                                    node.next = m_free;
+                                    // skip 0 on wrap around, the ids stay non zero
+                                    node.generation = node.generation + 1 ? node.generation + 1 : 1;
+                                    m_free = index;
+                                }
+
+private:
+    int64_t                     m_currentTick;          // every tick before it has been processed
+    std::array<uint32_t, LEVEL_COUNT * SLOT_COUNT>
+                                m_heads;
+    std::array<uint64_t, LEVEL_COUNT>
+                                m_occupied{};           // busy slots of every level
+    std::vector<Node>           m_nodes;
+    uint32_t                    m_free = NIL;
+    size_t                      m_size = 0;
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __TIMING_H__
+#define __TIMING_H__
+
+#include <chrono>
+#include <cstdint>
+
+namespace stockbot {
+
+// steady clock in nanoseconds, for latency stamps that are only compared within the process
+inline int64_t monotonicNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace stockbot
+
+#endif
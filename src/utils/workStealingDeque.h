@@ -0,0 +1,148 @@
+#ifndef __WORK_STEALING_DEQUE_H__
+#define __WORK_STEALING_DEQUE_H__
+
+#include "utils/ringQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace stockbot {
+
+// Chase-Lev work stealing deque (with the C11 orderings of Le et al. 2013).
+//
+// The owner thread pushes and pops at the bottom, LIFO, so it keeps working on what it just
+// produced while it is still in cache. Any other thread steals from the top, FIFO, the oldest
+// and usually largest chunk of work. Only the last item is contended.
+//
+// Grows when full. A thief may still be reading the old array, so old arrays are kept until
+// the deque is destroyed; they add up to less than the current one.
+//
+// T is copied in and out of the slots with relaxed atomics: small and trivially copyable, a
+// pointer in practice.
+template <typename T>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable_v<T>, "slots are read speculatively by thieves");
+
+    struct Array {
+        explicit                    Array(size_t capacity)
+                                        : mask(int64_t(capacity) - 1)
+                                        , slots(std::make_unique<std::atomic<T>[]>(capacity))
+                                    {}
+
+        int64_t                     capacity() const { return mask + 1; }
+        T                           get(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+        void                        put(int64_t index, T item) { slots[index & mask].store(item, std::memory_order_relaxed); }
+
+        int64_t                     mask;
+        std::unique_ptr<std::atomic<T>[]>
+                                    slots;
+    };
+
+public:
+    explicit                        WorkStealingDeque(size_t capacity = 256)
+                                    {
+                                        m_arrays.push_back(std::make_unique<Array>(std::bit_ceil(std::max<size_t>(capacity, 2))));
+                                        m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+                                    }
+
+                                    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque&              operator=(const WorkStealingDeque&) = delete;
+
+    // -- owner thread
+    void                            push(T item)
+                                    {
+                                        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                                        int64_t top = m_top.load(std::memory_order_acquire);
+                                        Array* array = m_array.load(std::memory_order_relaxed);
+                                        if (bottom - top > array->capacity() - 1) {
+                                            array = grow(array, top, bottom);
+                                        }
+                                        array->put(bottom, item);
+                                        // a release store rather than the paper's fence, same code on x86 and visible to tsan
+                                        m_bottom.store(bottom + 1, std::memory_order_release);
+                                    }
+
+    bool                            pop(T& item)
+                                    {
+                                        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                                        Array* array = m_array.load(std::memory_order_relaxed);
+                                        m_bottom.store(bottom, std::memory_order_relaxed);
+                                        // the thieves must see the reservation before we read top
+                                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                                        int64_t top = m_top.load(std::memory_order_relaxed);
+
+                                        if (top > bottom) {
+                                            // empty
+                                            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                                            return false;
+                                        }
+
+                                        item = array->get(bottom);
+                                        if (top < bottom) {
+                                            return true;
+                                        }
+
+                                        // last item, race the thieves for it
+                                        bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                                        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                                        return won;
+                                    }
+
+    // -- any thread, false when empty or lost to another thief / the owner
+    bool                            steal(T& item)
+                                    {
+                                        int64_t top = m_top.load(std::memory_order_acquire);
+                                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                                        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+                                        if (top >= bottom) {
+                                            return false;
+                                        }
+
+                                        T stolen = m_array.load(std::memory_order_acquire)->get(top);
+                                        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                                            return false;
+                                        }
+                                        item = stolen;
+                                        return true;
+                                    }
+
+    // approximate when read outside of the owner
+    size_t                          size() const
+                                    {
+                                        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                                        int64_t top = m_top.load(std::memory_order_relaxed);
+                                        return bottom > top ? size_t(bottom - top) : 0;
+                                    }
+
+private:
+    Array*                          grow(Array* array, int64_t top, int64_t bottom)
+                                    {
+                                        auto grown = std::make_unique<Array>(size_t(array->capacity()) * 2);
+                                        for (int64_t i = top; i < bottom; ++i) {
+                                            grown->put(i, array->get(i));
+                                        }
+                                        m_arrays.push_back(std::move(grown));
+                                        m_array.store(m_arrays.back().get(), std::memory_order_release);
+                                        return m_arrays.back().get();
+                                    }
+
+private:
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<int64_t>            m_top = 0;
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<int64_t>            m_bottom = 0;
+    std::atomic<Array*>             m_array;
+
+    std::vector<std::unique_ptr<Array>>
+                                    m_arrays;       // current one last, owner only
+};
+
+} // namespace stockbot
+
+#endif
@@ -0,0 +1,821 @@
+// Local stand-in for the Schwab endpoints stockbot talks to, for offline end to end runs.
+//
+// One port serves the REST calls (oauth token, user preference, account numbers, account
+// summary, orders) and the streamer websocket (/ws, the url handed out in the user preference).
+// The streamer implements ADMIN LOGIN / LOGOUT and LEVELONE_EQUITIES SUBS / ADD / UNSUBS and
+// sends synthetic quotes for the subscribed keys, or replays stream journals. Disconnects and
+// slow REST responses can be injected. With --cert / --key, TLS is detected per connection so
+// the same port also serves https / wss.
+//
+// Measured from the server side and printed on exit (ctrl-c):
+//   tick to order    time from the last frame carrying a symbol to an order for it
+//   recovery         time from an injected disconnect to the next SUBS
+// Stockbot measures its side itself, tick_to_decision in the pipeline latencies (stockbot_replay
+// prints them offline).
+//
+// Not an end to end run of App::run yet. schwabcpp::Client has its REST base url built in and
+// takes no override, so the App can't point it at the mock until external/schwabcpp grows one;
+// that part is left to a follow up in schwabcpp. The streamer url already comes from the user
+// preference the mock serves. Stockbot places no orders either, tick to order stays empty.
+//
+// usage: mock_schwab [options]
+//   --port <n>                 listen port (default 8443)
+//   --cert <pem> --key <pem>   enable TLS
+//   --rate <n>                 synthetic updates per second (default 1000)
+//   --journal <path>           replay a journal instead of synthetic data, repeatable
+//   --speed <x>                journal replay speed (default 1)
+//   --disconnect-every <s>     drop the streamer connection after s seconds of streaming
+//   --rest-delay <ms>          delay REST responses
+//   --rest-delay-rate <p>      fraction of REST responses delayed (default 1)
+//   --heartbeat <s>            streamer heartbeat interval (default 10)
+
+#include "journal/streamJournalReader.h"
+#include "stream/streamFrameDecoder.h"
+#include "stream/syntheticFrameGenerator.h"
+#include "nlohmann/json.hpp"
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace stockbot;
+using json = nlohmann::json;
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+using tcp = net::ip::tcp;
+using net::awaitable;
+using net::use_awaitable;
+using steady_clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    unsigned short port = 8443;
+    std::string certPath;
+    std::string keyPath;
+    double rate = 1000.0;
+    std::vector<std::string> journals;
+    double speed = 1.0;
+    double disconnectEverySeconds = 0.0;
+    int restDelayMs = 0;
+    double restDelayRate = 1.0;
+    double heartbeatSeconds = 10.0;
+};
+
+double millisecondsBetween(steady_clock::time_point from, steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+int64_t epochMilliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// State shared by all connections. Everything runs on the one io_context thread, no locking.
+struct Server {
+    Options options;
+    std::mt19937_64 rng{ 7 };
+
+    // -- accounts
+    struct Account {
+        std::string number;
+        std::string hash;
+        std::string nickName;
+        bool primary;
+        double cash;
+    };
+    std::vector<Account> accounts = {
+        { "12345678", "A1B2C3D4E5F6", "Individual", true, 25000.0 },
+        { "87654321", "F6E5D4C3B2A1", "Roth IRA", false, 8000.0 },
+    };
+    std::vector<json> orders;
+
+    // -- measurements
+    uint64_t sessions = 0;
+    uint64_t framesSent = 0;
+    std::unordered_map<std::string, steady_clock::time_point> lastTickSent;
+    std::vector<double> tickToOrderMs;
+    std::optional<steady_clock::time_point> injectedDisconnectAt;
+    std::vector<double> recoveryMs;
+
+    bool tls() const { return !options.certPath.empty(); }
+
+    const Account* findAccount(std::string_view hash) const
+    {
+        for (const Account& account : accounts) {
+            if (account.hash == hash) return &account;
+        }
+        return nullptr;
+    }
+};
+
+std::string heartbeatMessage()
+{
+    return json{
+        {"notify", json::array({ {{"heartbeat", std::to_string(epochMilliseconds())}} })}
+    }.dump();
+}
+
+// -- streamer data sources
+
+class Feed
+{
+public:
+    virtual ~Feed() = default;
+
+    // when the next frame is due, nullopt if there is nothing to send
+    virtual std::optional<steady_clock::time_point> nextDue() = 0;
+    virtual void next(std::string& frame) = 0;
+    virtual void setKeys(const std::set<std::string>& keys) = 0;
+};
+
+// quotes for exactly the subscribed keys, a new subscription starts with a full quote
+class SyntheticFeed : public Feed
+{
+public:
+    SyntheticFeed(double rate, uint64_t seed) : m_rate(rate), m_seed(seed) {}
+
+    std::optional<steady_clock::time_point> nextDue() override
+    {
+        if (!m_generator) return std::nullopt;
+        if (m_pending.empty()) {
+            m_pendingDue = m_start + m_generator->next(m_pending);
+        }
+        return m_pendingDue;
+    }
+
+    void next(std::string& frame) override
+    {
+        nextDue();
+        frame.swap(m_pending);
+        m_pending.clear();
+    }
+
+    void setKeys(const std::set<std::string>& keys) override
+    {
+        m_generator.reset();
+        m_pending.clear();
+        if (!keys.empty()) {
+            m_start = steady_clock::now();
+            m_generator = std::make_unique<SyntheticFrameGenerator>(SyntheticFrameGenerator::Spec{
+                .tickers = std::vector<std::string>(keys.begin(), keys.end()),
+                .updatesPerSecond = m_rate,
+                .seed = ++m_seed,
+                .startTimestampMs = epochMilliseconds(),
+            });
+        }
+    }
+
+private:
+    double m_rate;
+    uint64_t m_seed;
+    std::unique_ptr<SyntheticFrameGenerator> m_generator;
+    steady_clock::time_point m_start;
+    std::string m_pending;
+    steady_clock::time_point m_pendingDue;
+};
+
+// the recorded frames as they are, at the recorded pace, looping
+class JournalFeed : public Feed
+{
+public:
+    JournalFeed(const std::vector<std::string>& paths, double speed) : m_speed(speed)
+    {
+        for (const std::string& path : paths) {
+            auto reader = std::make_unique<StreamJournalReader>();
+            if (reader->open(path)) {
+                m_journals.push_back(std::move(reader));
+            } else {
+                std::fprintf(stderr, "skipping %s, not a readable stream journal\n", path.c_str());
+            }
+        }
+    }
+
+    std::optional<steady_clock::time_point> nextDue() override
+    {
+        if (!m_streaming || m_journals.empty()) return std::nullopt;
+        if (!m_havePending) {
+            advance();
+        }
+        return m_pendingDue;
+    }
+
+    void next(std::string& frame) override
+    {
+        nextDue();
+        frame.assign(m_pending.frame);
+        m_havePending = false;
+    }
+
+    // recorded frames carry their own keys, only whether anything is subscribed matters
+    void setKeys(const std::set<std::string>& keys) override
+    {
+        bool streaming = !keys.empty();
+        if (streaming && !m_streaming) {
+            m_base = steady_clock::now();
+            m_firstNs = -1;
+        }
+        m_streaming = streaming;
+    }
+
+private:
+    void advance()
+    {
+        // the monotonic stamps of two journals are unrelated, every journal restarts the pace
+        while (!m_journals[m_current]->next(m_pending)) {
+            m_journals[m_current]->rewind();
+            m_current = (m_current + 1) % m_journals.size();
+            m_base = std::max(m_base, steady_clock::now());
+            m_firstNs = -1;
+        }
+        if (m_firstNs < 0) {
+            m_firstNs = m_pending.monotonicNs;
+            m_base = std::max(m_base, steady_clock::now());
+        }
+        m_pendingDue = m_base + std::chrono::nanoseconds(int64_t((m_pending.monotonicNs - m_firstNs) / m_speed));
+        m_havePending = true;
+    }
+
+    double m_speed;
+    std::vector<std::unique_ptr<StreamJournalReader>> m_journals;
+    size_t m_current = 0;
+    bool m_streaming = false;
+    steady_clock::time_point m_base;
+    int64_t m_firstNs = -1;
+    StreamJournalReader::Record m_pending{};
+    bool m_havePending = false;
+    steady_clock::time_point m_pendingDue;
+};
+
+// remembers when each symbol was last sent, for the tick to order latency
+class TickTracker : public StreamFrameDecoder::Handler
+{
+public:
+    TickTracker(Server& server) : m_server(server) {}
+
+    void onLevelOneEquity(std::string_view ticker, const LevelOneFieldSet&) override
+    {
+        m_server.lastTickSent[std::string(ticker)] = m_now;
+    }
+
+    void sent(const std::string& frame)
+    {
+        m_now = steady_clock::now();
+        m_decoder.decode(frame, *this);
+    }
+
+private:
+    Server& m_server;
+    StreamFrameDecoder m_decoder;
+    steady_clock::time_point m_now;
+};
+
+// -- streamer
+
+template <typename WebSocket>
+class StreamerSession : public std::enable_shared_from_this<StreamerSession<WebSocket>>
+{
+public:
+    StreamerSession(WebSocket& ws, Server& server)
+        : m_ws(ws)
+        , m_server(server)
+        , m_timer(ws.get_executor())
+        , m_ticks(server)
+    {
+        if (server.options.journals.empty()) {
+            m_feed = std::make_unique<SyntheticFeed>(server.options.rate, server.rng());
+        } else {
+            m_feed = std::make_unique<JournalFeed>(server.options.journals, server.options.speed);
+        }
+    }
+
+    // reads requests until the client goes away, the pump does all the writing
+    awaitable<void> run()
+    {
+        m_sessionId = ++m_server.sessions;
+        std::printf("[streamer %llu] connected\n", (unsigned long long)m_sessionId);
+
+        net::co_spawn(m_ws.get_executor(), pump(this->shared_from_this()), net::detached);
+
+        try {
+            while (!m_closed) {
+                beast::flat_buffer buffer;
+                co_await m_ws.async_read(buffer, use_awaitable);
+                handleRequests(beast::buffers_to_string(buffer.data()));
+                m_timer.cancel();
+            }
+        } catch (const std::exception&) {
+            // closed by either side
+        }
+
+        m_closed = true;
+        m_timer.cancel();
+        // the websocket lives in the caller's frame, wait for the pump to let go of it
+        net::steady_timer wait(m_ws.get_executor());
+        while (m_pumping) {
+            wait.expires_after(std::chrono::milliseconds(1));
+            co_await wait.async_wait(use_awaitable);
+        }
+
+        std::printf("[streamer %llu] disconnected\n", (unsigned long long)m_sessionId);
+    }
+
+private:
+    void handleRequests(const std::string& message)
+    {
+        json parsed = json::parse(message, nullptr, false);
+        if (parsed.is_discarded() || !parsed.contains("requests")) {
+            std::printf("[streamer %llu] ignoring %s\n", (unsigned long long)m_sessionId, message.c_str());
+            return;
+        }
+
+        for (const json& request : parsed["requests"]) {
+            std::string service = request.value("service", "");
+            std::string command = request.value("command", "");
+            std::string keys = request.contains("parameters") ? request["parameters"].value("keys", "") : "";
+
+            int code = 0;
+            std::string msg;
+            if (service == "ADMIN" && command == "LOGIN") {
+                m_loggedIn = true;
+                msg = "server=mock;status=PN";
+            } else if (service == "ADMIN" && command == "LOGOUT") {
+                msg = "Logout successful";
+                m_closing = true;
+            } else if (!m_loggedIn) {
+                code = 3;
+                msg = "Login required";
+            } else if (service == "LEVELONE_EQUITIES") {
+                msg = updateKeys(command, keys);
+            } else {
+                // accepted, the mock has no data for other services
+                msg = command + " command succeeded";
+            }
+
+            m_outgoing.push_back(json{
+                {"response", json::array({
+                    {
+                        {"service", service},
+                        {"command", command},
+                        {"requestid", request.value("requestid", "")},
+                        {"SchwabClientCorrelId", request.value("SchwabClientCorrelId", "")},
+                        {"timestamp", epochMilliseconds()},
+                        {"content", {{"code", code}, {"msg", msg}}},
+                    }
+                })}
+            }.dump());
+        }
+    }
+
+    std::string updateKeys(const std::string& command, const std::string& keyList)
+    {
+        std::set<std::string> keys;
+        size_t begin = 0;
+        while (begin < keyList.size()) {
+            size_t end = std::min(keyList.find(',', begin), keyList.size());
+            if (end > begin) {
+                keys.emplace(keyList.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+
+        if (command == "SUBS") {
+            m_keys = keys;
+        } else if (command == "ADD") {
+            m_keys.insert(keys.begin(), keys.end());
+        } else if (command == "UNSUBS") {
+            for (const std::string& key : keys) {
+                m_keys.erase(key);
+            }
+        } else {
+            return command + " command succeeded";
+        }
+        m_feed->setKeys(m_keys);
+
+        if (command != "UNSUBS" && m_server.injectedDisconnectAt) {
+            double recovery = millisecondsBetween(*m_server.injectedDisconnectAt, steady_clock::now());
+            m_server.recoveryMs.push_back(recovery);
+            m_server.injectedDisconnectAt.reset();
+            std::printf("[streamer %llu] resubscribed %.1f ms after the injected disconnect\n", (unsigned long long)m_sessionId, recovery);
+        }
+        if (!m_keys.empty() && !m_streamingSince) {
+            m_streamingSince = steady_clock::now();
+        }
+
+        std::printf("[streamer %llu] %s %s, %zu keys subscribed\n", (unsigned long long)m_sessionId, command.c_str(), keyList.c_str(), m_keys.size());
+        return command + " command succeeded";
+    }
+
+    // writes the responses, the data frames and the heartbeats
+    static awaitable<void> pump(std::shared_ptr<StreamerSession> self)
+    {
+        self->m_pumping = true;
+        const Options& options = self->m_server.options;
+        auto heartbeat = std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(options.heartbeatSeconds));
+        auto nextHeartbeat = steady_clock::now() + heartbeat;
+        std::string frame;
+
+        try {
+            while (!self->m_closed) {
+                while (!self->m_outgoing.empty()) {
+                    std::string message = std::move(self->m_outgoing.front());
+                    self->m_outgoing.pop_front();
+                    co_await self->m_ws.async_write(net::buffer(message), use_awaitable);
+                }
+
+                if (self->m_closing) {
+                    co_await self->m_ws.async_close(websocket::close_code::normal, use_awaitable);
+                    break;
+                }
+
+                auto now = steady_clock::now();
+                if (options.disconnectEverySeconds > 0.0 && self->m_streamingSince &&
+                    millisecondsBetween(*self->m_streamingSince, now) >= options.disconnectEverySeconds * 1000.0) {
+                    // like a dropped network, no close frame
+                    std::printf("[streamer %llu] injecting a disconnect\n", (unsigned long long)self->m_sessionId);
+                    self->m_server.injectedDisconnectAt = now;
+                    beast::get_lowest_layer(self->m_ws).close();
+                    break;
+                }
+
+                if (now >= nextHeartbeat) {
+                    std::string message = heartbeatMessage();
+                    co_await self->m_ws.async_write(net::buffer(message), use_awaitable);
+                    nextHeartbeat += heartbeat;
+                    continue;
+                }
+
+                auto wake = nextHeartbeat;
+                if (std::optional<steady_clock::time_point> due = self->m_loggedIn ? self->m_feed->nextDue() : std::nullopt) {
+                    if (now >= *due) {
+                        self->m_feed->next(frame);
+                        co_await self->m_ws.async_write(net::buffer(frame), use_awaitable);
+                        self->m_ticks.sent(frame);
+                        ++self->m_server.framesSent;
+                        continue;
+                    }
+                    wake = std::min(wake, *due);
+                }
+
+                // the reader cancels the timer when there is something to answer
+                self->m_timer.expires_at(wake);
+                try {
+                    co_await self->m_timer.async_wait(use_awaitable);
+                } catch (const boost::system::system_error&) {
+                }
+            }
+        } catch (const std::exception&) {
+            // write failed, the reader sees the closed socket too
+            beast::get_lowest_layer(self->m_ws).close();
+        }
+
+        self->m_closed = true;
+        self->m_pumping = false;
+    }
+
+private:
+    WebSocket& m_ws;
+    Server& m_server;
+    net::steady_timer m_timer;
+    std::unique_ptr<Feed> m_feed;
+    TickTracker m_ticks;
+    std::deque<std::string> m_outgoing;
+    std::set<std::string> m_keys;
+    std::optional<steady_clock::time_point> m_streamingSince;
+    uint64_t m_sessionId = 0;
+    bool m_loggedIn = false;
+    bool m_closing = false;
+    bool m_closed = false;
+    bool m_pumping = false;
+};
+
+// -- rest
+
+using Request = http::request<http::string_body>;
+using Response = http::response<http::string_body>;
+
+Response jsonResponse(const Request& request, http::status status, const json& body)
+{
+    Response response(status, request.version());
+    response.set(http::field::content_type, "application/json");
+    response.body() = body.dump();
+    return response;
+}
+
+json accountSummary(const Server::Account& account)
+{
+    json balances = {
+        {"cashBalance", account.cash},
+        {"cashAvailableForTrading", account.cash},
+        {"liquidationValue", account.cash},
+        {"longMarketValue", 0.0},
+        {"totalCash", account.cash},
+    };
+    return {
+        {"securitiesAccount", {
+            {"type", "CASH"},
+            {"accountNumber", account.number},
+            {"roundTrips", 0},
+            {"isDayTrader", false},
+            {"isClosingOnlyRestricted", false},
+            {"pfcbFlag", false},
+            {"positions", json::array()},
+            {"initialBalances", balances},
+            {"currentBalances", balances},
+            {"projectedBalances", balances},
+        }},
+        {"aggregatedBalance", {
+            {"currentLiquidationValue", account.cash},
+            {"liquidationValue", account.cash},
+        }},
+    };
+}
+
+Response placeOrder(const Request& request, Server& server, const Server::Account& account, const std::string& base)
+{
+    json order = json::parse(request.body(), nullptr, false);
+    if (order.is_discarded()) {
+        return jsonResponse(request, http::status::bad_request, {{"message", "Invalid order"}});
+    }
+
+    uint64_t orderId = 1000 + server.orders.size();
+    order["orderId"] = orderId;
+    order["accountNumber"] = account.number;
+    order["status"] = "WORKING";
+    order["enteredTime"] = epochMilliseconds();
+
+    std::string symbol;
+    if (order.contains("orderLegCollection") && !order["orderLegCollection"].empty()) {
+        symbol = order["orderLegCollection"][0]["instrument"].value("symbol", "");
+    }
+    if (auto found = server.lastTickSent.find(symbol); found != server.lastTickSent.end()) {
+        double latency = millisecondsBetween(found->second, steady_clock::now());
+        server.tickToOrderMs.push_back(latency);
+        std::printf("[rest] order %llu for %s, %.2f ms after its last tick\n", (unsigned long long)orderId, symbol.c_str(), latency);
+    } else {
+        std::printf("[rest] order %llu for %s\n", (unsigned long long)orderId, symbol.c_str());
+    }
+    server.orders.push_back(std::move(order));
+
+    Response response(http::status::created, request.version());
+    response.set(http::field::location, base + "/trader/v1/accounts/" + account.hash + "/orders/" + std::to_string(orderId));
+    return response;
+}
+
+awaitable<Response> handleRest(const Request& request, Server& server, const std::string& host)
+{
+    const Options& options = server.options;
+    if (options.restDelayMs > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(server.rng) < options.restDelayRate) {
+        net::steady_timer delay(co_await net::this_coro::executor, std::chrono::milliseconds(options.restDelayMs));
+        co_await delay.async_wait(use_awaitable);
+    }
+
+    std::string target(request.target());
+    std::string path = target.substr(0, target.find('?'));
+    std::string base = (server.tls() ? "https://" : "http://") + host;
+    std::printf("[rest] %s %s\n", std::string(request.method_string()).c_str(), target.c_str());
+
+    if (request.method() == http::verb::post && path == "/v1/oauth/token") {
+        co_return jsonResponse(request, http::status::ok, {
+            {"expires_in", 1800},
+            {"token_type", "Bearer"},
+            {"scope", "api"},
+            {"refresh_token", "mock-refresh-token"},
+            {"access_token", "mock-access-token"},
+            {"id_token", "mock-id-token"},
+        });
+    }
+
+    if (request.method() == http::verb::get && path == "/trader/v1/userPreference") {
+        json accounts = json::array();
+        for (const Server::Account& account : server.accounts) {
+            accounts.push_back({
+                {"accountNumber", account.number},
+                {"primaryAccount", account.primary},
+                {"type", "BROKERAGE"},
+                {"nickName", account.nickName},
+                {"displayAcctId", "..." + account.number.substr(account.number.size() - 3)},
+                {"autoPositionEffect", false},
+                {"accountColor", "Green"},
+            });
+        }
+        co_return jsonResponse(request, http::status::ok, {
+            {"accounts", accounts},
+            {"streamerInfo", json::array({
+                {
+                    {"streamerSocketUrl", (server.tls() ? "wss://" : "ws://") + host + "/ws"},
+                    {"schwabClientCustomerId", "mock-customer-id"},
+                    {"schwabClientCorrelId", "mock-correl-id"},
+                    {"schwabClientChannel", "N9"},
+                    {"schwabClientFunctionId", "APIAPP"},
+                }
+            })},
+            {"offers", json::array({ {{"level2Permissions", true}, {"mktDataPermission", "NP"}} })},
+        });
+    }
+
+    if (request.method() == http::verb::get && path == "/trader/v1/accounts/accountNumbers") {
+        json numbers = json::array();
+        for (const Server::Account& account : server.accounts) {
+            numbers.push_back({{"accountNumber", account.number}, {"hashValue", account.hash}});
+        }
+        co_return jsonResponse(request, http::status::ok, numbers);
+    }
+
+    if (request.method() == http::verb::get && path == "/trader/v1/accounts") {
+        json summaries = json::array();
+        for (const Server::Account& account : server.accounts) {
+            summaries.push_back(accountSummary(account));
+        }
+        co_return jsonResponse(request, http::status::ok, summaries);
+    }
+
+    // /trader/v1/accounts/<hash>[/orders]
+    static const std::string ACCOUNTS_PREFIX = "/trader/v1/accounts/";
+    if (path.starts_with(ACCOUNTS_PREFIX)) {
+        std::string rest = path.substr(ACCOUNTS_PREFIX.size());
+        std::string hash = rest.substr(0, rest.find('/'));
+        std::string resource = rest.substr(hash.size());
+
+        const Server::Account* account = server.findAccount(hash);
+        if (!account) {
+            co_return jsonResponse(request, http::status::not_found, {{"message", "Account not found"}});
+        }
+        if (request.method() == http::verb::get && resource.empty()) {
+            co_return jsonResponse(request, http::status::ok, accountSummary(*account));
+        }
+        if (request.method() == http::verb::post && resource == "/orders") {
+            co_return placeOrder(request, server, *account, base);
+        }
+        if (request.method() == http::verb::get && resource == "/orders") {
+            json orders = json::array();
+            for (const json& order : server.orders) {
+                if (order["accountNumber"] == account->number) {
+                    orders.push_back(order);
+                }
+            }
+            co_return jsonResponse(request, http::status::ok, orders);
+        }
+    }
+
+    co_return jsonResponse(request, http::status::not_found, {{"message", "Not found"}});
+}
+
+// -- connections
+
+template <typename Stream>
+awaitable<void> serve(Stream& stream, beast::flat_buffer& buffer, Server& server)
+{
+    while (true) {
+        Request request;
+        co_await http::async_read(stream, buffer, request, use_awaitable);
+
+        if (websocket::is_upgrade(request)) {
+            websocket::stream<Stream&> ws(stream);
+            co_await ws.async_accept(request, use_awaitable);
+            auto session = std::make_shared<StreamerSession<websocket::stream<Stream&>>>(ws, server);
+            co_await session->run();
+            co_return;
+        }
+
+        std::string host(request[http::field::host]);
+        if (host.empty()) {
+            host = "127.0.0.1:" + std::to_string(server.options.port);
+        }
+        Response response = co_await handleRest(request, server, host);
+        response.keep_alive(request.keep_alive());
+        response.prepare_payload();
+        co_await http::async_write(stream, response, use_awaitable);
+        if (!response.keep_alive()) {
+            co_return;
+        }
+    }
+}
+
+awaitable<void> handleConnection(tcp::socket socket, Server& server, net::ssl::context* tls)
+{
+    beast::tcp_stream stream(std::move(socket));
+    beast::flat_buffer buffer;
+    try {
+        if (tls && co_await beast::async_detect_ssl(stream, buffer, use_awaitable)) {
+            beast::ssl_stream<beast::tcp_stream> tlsStream(std::move(stream), *tls);
+            size_t used = co_await tlsStream.async_handshake(net::ssl::stream_base::server, buffer.data(), use_awaitable);
+            buffer.consume(used);
+            co_await serve(tlsStream, buffer, server);
+        } else {
+            co_await serve(stream, buffer, server);
+        }
+    } catch (const std::exception&) {
+        // connection closed
+    }
+}
+
+awaitable<void> listen(tcp::acceptor& acceptor, Server& server, net::ssl::context* tls)
+{
+    while (true) {
+        tcp::socket socket = co_await acceptor.async_accept(use_awaitable);
+        socket.set_option(tcp::no_delay(true));
+        net::co_spawn(acceptor.get_executor(), handleConnection(std::move(socket), server, tls), net::detached);
+    }
+}
+
+void printLatency(const char* name, std::vector<double> samples)
+{
+    if (samples.empty()) {
+        std::printf("  %-14s -\n", name);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, size_t(p * samples.size()))]; };
+    std::printf("  %-14s n=%zu p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", name, samples.size(), percentile(0.5), percentile(0.99), samples.back());
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mock_schwab [--port <n>] [--cert <pem> --key <pem>] [--rate <n>] [--journal <path>]... "
+                 "[--speed <x>] [--disconnect-every <s>] [--rest-delay <ms>] [--rest-delay-rate <p>] [--heartbeat <s>]\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Server server;
+    Options& options = server.options;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--port") && hasValue) {
+            options.port = static_cast<unsigned short>(std::atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--cert") && hasValue) {
+            options.certPath = argv[++i];
+        } else if (!strcmp(argv[i], "--key") && hasValue) {
+            options.keyPath = argv[++i];
+        } else if (!strcmp(argv[i], "--rate") && hasValue) {
+            options.rate = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--journal") && hasValue) {
+            options.journals.push_back(argv[++i]);
+        } else if (!strcmp(argv[i], "--speed") && hasValue) {
+            options.speed = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--disconnect-every") && hasValue) {
+            options.disconnectEverySeconds = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--rest-delay") && hasValue) {
+            options.restDelayMs = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--rest-delay-rate") && hasValue) {
+            options.restDelayRate = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--heartbeat") && hasValue) {
+            options.heartbeatSeconds = std::atof(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (options.certPath.empty() != options.keyPath.empty() || options.rate <= 0.0 || options.speed <= 0.0 || options.heartbeatSeconds <= 0.0) {
+        usage();
+        return 1;
+    }
+
+    net::io_context context;
+
+    std::unique_ptr<net::ssl::context> tls;
+    if (server.tls()) {
+        tls = std::make_unique<net::ssl::context>(net::ssl::context::tls_server);
+        tls->use_certificate_chain_file(options.certPath);
+        tls->use_private_key_file(options.keyPath, net::ssl::context::pem);
+    }
+
+    // localhost only
+    tcp::acceptor acceptor(context, tcp::endpoint(net::ip::make_address("127.0.0.1"), options.port));
+    net::co_spawn(context, listen(acceptor, server, tls.get()), net::detached);
+
+    net::signal_set signals(context, SIGINT, SIGTERM);
+    signals.async_wait([&](const boost::system::error_code&, int) { context.stop(); });
+
+    std::printf("mock schwab listening on %s://127.0.0.1:%u (%s)\n", server.tls() ? "https" : "http", options.port,
+                options.journals.empty() ? "synthetic quotes" : "journal replay");
+    context.run();
+
+    std::printf("\n%llu streamer sessions, %llu frames sent, %zu orders\n",
+                (unsigned long long)server.sessions, (unsigned long long)server.framesSent, server.orders.size());
+    printLatency("tick to order", server.tickToOrderMs);
+    printLatency("recovery", server.recoveryMs);
+
+    return 0;
+}
@@ -0,0 +1,315 @@
+// Offline replay of recorded stream journals through the ingest path.
+//
+// Feeds every frame of the journals to InvestmentManager::enqueueStreamData the way the
+// streamer handler does, with no discord bot and no schwab client. Every ticker found in the
+// journals is registered as an investment first so its ticks make it through to the tasks.
+//
+// usage: stockbot_replay [options] <journal>...
+//   --speed <x>    replay at x times the recorded pace (default 1, real time)
+//   --max          as fast as possible
+//   --workers <n>  stream workers (default 2)
+//   --tasks <n>    task manager pool size (default 2)
+//   --shared       shared instead of partitioned ingest
+//   --conflate     conflate updates (partitioned ingest only)
+//   --verbose      keep the investment manager logs
+
+#include "investmentHost.h"
+#include "investmentManager.h"
+#include "journal/streamJournalReader.h"
+#include "rule/tradingWindow.h"
+#include "stream/streamFrameDecoder.h"
+#include "taskManager.h"
+#include "utils/latencyMetrics.h"
+#include "utils/logger.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace stockbot;
+using steady_clock = std::chrono::steady_clock;
+
+namespace {
+
+int64_t nanosecondsBetween(steady_clock::time_point from, steady_clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+// prints one row of a latency table, in us
+void printSummary(const char* stage, const LatencySummary& summary)
+{
+    if (summary.count == 0) {
+        std::printf("  %-22s %10s\n", stage, "-");
+        return;
+    }
+    std::printf("  %-22s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                stage, (unsigned long long)summary.count,
+                summary.p50 / 1e3, summary.p90 / 1e3, summary.p99 / 1e3, summary.p999 / 1e3, summary.max / 1e3);
+}
+
+LatencySummary summarize(const LatencyHistogram& histogram)
+{
+    LatencyHistogram::Counts counts{};
+    uint64_t sum = 0;
+    histogram.addTo(counts, sum);
+    return stockbot::summarize(counts, sum);
+}
+
+// stands in for the App, tasks go to a real task manager
+class ReplayHost : public InvestmentHost
+{
+public:
+    ReplayHost(int poolSize, std::shared_ptr<spdlog::logger> logger)
+        : m_taskManager(std::make_unique<TaskManager>(TaskManager::Spec{ .poolSize = poolSize }, logger))
+    {
+        m_taskManager->run();
+    }
+
+    void subscribeTickersToStream(const std::vector<std::string>& tickers) override
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_subscribed += tickers.size();
+        }
+        m_cv.notify_all();
+    }
+
+    void registerTask(Task task, const TaskOptions& options) override
+    {
+        m_taskManager->addTask(std::move(task), options);
+    }
+
+    TimerId scheduleTask(int64_t dueNs, Task task, const TaskOptions& options) override
+    {
+        return m_taskManager->addTimer(dueNs, std::move(task), options);
+    }
+
+    void cancelScheduledTask(TimerId id) override { m_taskManager->cancelTimer(id); }
+
+    bool waitForSubscriptions(size_t count, std::chrono::seconds timeout)
+    {
+        std::unique_lock lock(m_mutex);
+        return m_cv.wait_for(lock, timeout, [&] { return m_subscribed >= count; });
+    }
+
+    // runs the tasks still queued
+    void drain() { m_taskManager->stop(); }
+
+private:
+    std::unique_ptr<TaskManager> m_taskManager;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_subscribed = 0;
+};
+
+// collects the tickers and counts the ticks of the journals
+class TickerCollector : public StreamFrameDecoder::Handler
+{
+public:
+    void onLevelOneEquity(std::string_view ticker, const LevelOneFieldSet&) override
+    {
+        if (!m_tickers.contains(ticker)) {
+            m_tickers.emplace(ticker);
+        }
+        ++m_ticks;
+    }
+
+    std::set<std::string, std::less<>> m_tickers;
+    uint64_t m_ticks = 0;
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: stockbot_replay [--speed <x> | --max] [--workers <n>] [--tasks <n>] "
+                 "[--shared] [--conflate] [--verbose] <journal>...\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    double speed = 1.0;
+    int workers = 2;
+    int taskPoolSize = 2;
+    bool partitioned = true;
+    bool conflate = false;
+    bool verbose = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--max")) {
+            speed = 0.0;
+        } else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--tasks") && i + 1 < argc) {
+            taskPoolSize = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--shared")) {
+            partitioned = false;
+        } else if (!strcmp(argv[i], "--conflate")) {
+            conflate = true;
+        } else if (!strcmp(argv[i], "--verbose")) {
+            verbose = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty() || speed < 0.0) {
+        usage();
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<StreamJournalReader>> journals;
+    for (const std::string& path : paths) {
+        journals.push_back(std::make_unique<StreamJournalReader>());
+        if (!journals.back()->open(path)) {
+            std::fprintf(stderr, "%s is not a readable stream journal\n", path.c_str());
+            return 1;
+        }
+    }
+
+    // tickers to register and the expected tick count
+    TickerCollector collector;
+    uint64_t frameCount = 0;
+    {
+        StreamFrameDecoder decoder;
+        StreamJournalReader::Record record;
+        for (auto& journal : journals) {
+            while (journal->next(record)) {
+                decoder.decode(record.frame, collector);
+                ++frameCount;
+            }
+            journal->rewind();
+        }
+    }
+    std::printf("%llu frames, %llu ticks, %zu tickers in %zu journal(s)\n",
+                (unsigned long long)frameCount, (unsigned long long)collector.m_ticks,
+                collector.m_tickers.size(), journals.size());
+
+    Logger::init(spdlog::level::info);
+    std::shared_ptr<spdlog::logger> investmentManagerLogger = Logger::createWithSharedSinksAndLevel("InvestmentManager");
+    std::shared_ptr<spdlog::logger> taskManagerLogger = Logger::createWithSharedSinksAndLevel("TaskManager");
+    if (!verbose) {
+        // the tasks log every snapshot
+        investmentManagerLogger->set_level(spdlog::level::warn);
+        taskManagerLogger->set_level(spdlog::level::warn);
+    }
+
+    auto host = std::make_shared<ReplayHost>(taskPoolSize, taskManagerLogger);
+    auto investmentManager = std::make_unique<InvestmentManager>(
+        InvestmentManager::Spec{
+            .streamWorkerCount = workers,
+            .partitionedIngest = partitioned,
+            .conflateUpdates = conflate,
+            .persistInvestments = false,
+        },
+        host,
+        investmentManagerLogger
+    );
+    investmentManager->run();
+
+    // Daily, already triggered in the current window: the rules and their due mask run on every
+    // tick like in a session past its trigger, nothing signals, the run measures ingest and the
+    // per tick task
+    const clock::rep triggered = windowOpen(AutoInvestment::Daily, clock::now()).time_since_epoch().count();
+    for (const std::string& ticker : collector.m_tickers) {
+        AutoInvestment investment{
+            .id = "replay-" + ticker,
+            .ticker = ticker,
+            .frequency = AutoInvestment::Daily,
+            .shares = 1,
+            .extras = 0,
+            .averageInThreshold = 0.0,
+            .skipThreshold = 0.0,
+            .createdTime = 0,
+            .lastTriggerTime = triggered,
+        };
+        investmentManager->addPendingInvestment(std::move(investment));
+        investmentManager->linkAndRegisterAutoInvestment("replay-" + ticker, {});
+    }
+    if (!host->waitForSubscriptions(collector.m_tickers.size(), std::chrono::seconds(10))) {
+        std::fprintf(stderr, "registration of the replayed tickers timed out\n");
+        return 1;
+    }
+
+    // The recorded pace is kept within a journal, the monotonic stamps of two journals come from
+    // different runs, so the next journal starts right after the previous one.
+    // recorded on this thread only, fixed size whatever the length of the journals
+    LatencyHistogram scheduleLag;
+    LatencyHistogram enqueue;
+    auto start = steady_clock::now();
+    {
+        StreamJournalReader::Record record;
+        for (auto& journal : journals) {
+            auto journalStart = steady_clock::now();
+            int64_t firstNs = -1;
+            while (journal->next(record)) {
+                if (speed > 0.0) {
+                    if (firstNs < 0) {
+                        firstNs = record.monotonicNs;
+                    }
+                    auto due = journalStart + std::chrono::nanoseconds(int64_t((record.monotonicNs - firstNs) / speed));
+                    std::this_thread::sleep_until(due);
+                    scheduleLag.record(nanosecondsBetween(due, steady_clock::now()));
+                }
+
+                auto before = steady_clock::now();
+                investmentManager->enqueueStreamData(std::string(record.frame));
+                enqueue.record(nanosecondsBetween(before, steady_clock::now()));
+            }
+        }
+    }
+    auto enqueued = steady_clock::now();
+
+    // same order as the App, the investment manager drains into the task manager
+    investmentManager->stop();
+    auto ingested = steady_clock::now();
+    host->drain();
+    auto finished = steady_clock::now();
+
+    InvestmentManager::StreamIngestStats stats = investmentManager->getStreamIngestStats();
+    investmentManager.reset();
+
+    double seconds = std::chrono::duration<double>(finished - start).count();
+    if (speed > 0.0) {
+        std::printf("\nreplayed in %.3f s (%gx)\n", seconds, speed);
+    } else {
+        std::printf("\nreplayed in %.3f s (max)\n", seconds);
+    }
+    std::printf("  frames/s       %12.0f\n", frameCount / seconds);
+    std::printf("  ticks/s        %12.0f\n", collector.m_ticks / seconds);
+    std::printf("  tasks run      %12llu\n", (unsigned long long)LatencyMetrics::instance().summary(LatencyStage::TaskRun, false).count);
+    if (partitioned) {
+        std::printf("  routed         %12llu\n", (unsigned long long)stats.updatesRouted);
+        std::printf("  conflated      %12llu\n", (unsigned long long)stats.updatesConflated);
+    }
+
+    // histogram buckets, the percentiles are upper bounds within ~3%
+    std::printf("\nreplay latency (us)\n");
+    std::printf("  %-22s %10s %10s %10s %10s %10s %10s\n", "stage", "samples", "p50", "p90", "p99", "p999", "max");
+    printSummary("schedule lag", summarize(scheduleLag));
+    printSummary("enqueue", summarize(enqueue));
+
+    std::printf("\npipeline latency (us)\n");
+    std::printf("  %-22s %10s %10s %10s %10s %10s %10s\n", "stage", "samples", "p50", "p90", "p99", "p999", "max");
+    for (size_t stage = 0; stage < size_t(LatencyStage::Count); ++stage) {
+        printSummary(toString(LatencyStage(stage)), LatencyMetrics::instance().summary(LatencyStage(stage)));
+    }
+    std::printf("  %-14s %10.1f ms after the last frame\n", "ingest drain", nanosecondsBetween(enqueued, ingested) / 1e6);
+    std::printf("  %-14s %10.1f ms after the ingest drain\n", "task drain", nanosecondsBetween(ingested, finished) / 1e6);
+
+    return 0;
+}